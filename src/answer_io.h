@@ -0,0 +1,114 @@
+#ifndef MULTIQUEUE_ANSWER_IO_H
+#define MULTIQUEUE_ANSWER_IO_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binary_heap.h"
+
+// Writing and reading the distances (or parents) computed by Dijkstra.
+//
+// The text format is one distance per line followed by an empty line. The binary format is a header
+// (binary_answer_magic, the size of one value and the number of values as uint64_t) followed by the raw values.
+
+const char binary_answer_magic[8] = {'M', 'Q', 'D', 'I', 'S', 'T', '1', '\0'};
+
+// Sign, digits and '\n'.
+const std::size_t max_chars_per_dist = std::numeric_limits<DistType>::digits10 + 3;
+
+// Writes dist and '\n' to out and returns the position after them.
+inline char * format_dist(char * out, DistType dist) {
+    char digits[max_chars_per_dist];
+    int num_digits = 0;
+    auto value = (int64_t)dist;
+    if (value < 0) {
+        *out++ = '-';
+        value = -value;
+    }
+    do {
+        digits[num_digits++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (num_digits > 0) {
+        *out++ = digits[--num_digits];
+    }
+    *out++ = '\n';
+    return out;
+}
+
+// Formats consecutive chunks of the distances in parallel and writes each chunk with one write.
+inline bool write_answer_text(const std::string & filename, const std::vector<DistType> & dists,
+                              std::size_t num_threads = std::thread::hardware_concurrency()) {
+    num_threads = std::max<std::size_t>(1, std::min(num_threads, dists.size() / 1'000'000 + 1));
+    const std::size_t chunk_size = (dists.size() + num_threads - 1) / num_threads;
+    std::vector<std::vector<char>> buffers(num_threads);
+    std::vector<std::thread> threads;
+    for (std::size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+        threads.emplace_back([&dists, &buffers, chunk_size, thread_id]() {
+            std::size_t begin = std::min(dists.size(), thread_id * chunk_size);
+            std::size_t end = std::min(dists.size(), begin + chunk_size);
+            std::vector<char> & buffer = buffers[thread_id];
+            buffer.resize((end - begin) * max_chars_per_dist);
+            char * out = buffer.data();
+            for (std::size_t i = begin; i < end; i++) {
+                out = format_dist(out, dists[i]);
+            }
+            buffer.resize(out - buffer.data());
+        });
+    }
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+    std::ofstream output(filename, std::ios::binary);
+    for (const std::vector<char> & buffer : buffers) {
+        output.write(buffer.data(), (std::streamsize)buffer.size());
+    }
+    output.put('\n');
+    return output.good();
+}
+
+template<class T>
+bool write_answer_binary(const std::string & filename, const std::vector<T> & dists) {
+    std::ofstream output(filename, std::ios::binary);
+    const auto dist_size = (uint64_t)sizeof(T);
+    const auto num_dists = (uint64_t)dists.size();
+    output.write(binary_answer_magic, sizeof(binary_answer_magic));
+    output.write(reinterpret_cast<const char *>(&dist_size), sizeof(dist_size));
+    output.write(reinterpret_cast<const char *>(&num_dists), sizeof(num_dists));
+    output.write(reinterpret_cast<const char *>(dists.data()), (std::streamsize)(dists.size() * sizeof(T)));
+    return output.good();
+}
+
+// Returns false if the file doesn't exist or isn't a binary answer with values of the same size, or if its size
+// doesn't match the number of values in its header, e.g. when it's truncated.
+template<class T>
+bool read_answer_binary(const std::string & filename, std::vector<T> & dists) {
+    std::ifstream input(filename, std::ios::binary | std::ios::ate);
+    const std::streamoff file_size = input.tellg();
+    input.seekg(0);
+    char magic[sizeof(binary_answer_magic)];
+    uint64_t dist_size = 0;
+    uint64_t num_dists = 0;
+    input.read(magic, sizeof(magic));
+    input.read(reinterpret_cast<char *>(&dist_size), sizeof(dist_size));
+    input.read(reinterpret_cast<char *>(&num_dists), sizeof(num_dists));
+    if (!input.good() || std::memcmp(magic, binary_answer_magic, sizeof(magic)) != 0
+            || dist_size != sizeof(T)) {
+        return false;
+    }
+    const auto data_size = (uint64_t)(file_size - input.tellg());
+    if (num_dists > data_size / sizeof(T) || num_dists * sizeof(T) != data_size) {
+        return false;
+    }
+    dists.resize(num_dists);
+    input.read(reinterpret_cast<char *>(dists.data()), (std::streamsize)(num_dists * sizeof(T)));
+    return input.good();
+}
+
+#endif //MULTIQUEUE_ANSWER_IO_H
@@ -1,3 +1,7 @@
+#include <cctype>
+#include <future>
+#include <memory>
+#include <sstream>
 #include <thread>
 #include <utility>
 
@@ -5,24 +9,141 @@
 
 #include <boost/thread/barrier.hpp>
 
+#include "answer_io.h"
+#include "compressed_graph.h"
+#include "contraction_hierarchies.h"
 #include "dijkstra.h"
+#include "generators.h"
+#include "harness.h"
+#include "hybrid_dijkstra.h"
+#include "incremental_dijkstra.h"
+#include "layouts.h"
+#include "mst.h"
+#include "sequential_dijkstra.h"
+#include "stealing_queue.h"
+#include "throughput.h"
 #include "utils.h"
+#include "verify.h"
 
 using Implementation = std::pair<std::function<DistsAndStatistics(const AdjList &, Timer &)>, std::string>;
 using BindedImpl = std::pair<std::function<DistsAndStatistics(Timer &)>, std::string>;
+using MSTImplementation = std::pair<std::function<MSTResult(const AdjList &, Timer &)>, std::string>;
+
+const std::string default_engine = "multiqueue";
+
+/* The Multiqueue Dijkstra with another distance type than DistType. */
+bool is_dist_engine(const std::string & engine) {
+    return engine == "multiqueue_uint32" || engine == "multiqueue_uint64" || engine == "multiqueue_float";
+}
+
+/* The tuned sequential Dijkstras on CompactGraph. */
+bool is_sequential_engine(const std::string & engine) {
+    return engine == "sequential_dary" || engine == "sequential_radix" || engine == "sequential_dial";
+}
+
+/* One line of a params file: num_threads K [queue_layout element_layout], or another engine: adaptive num_threads K,
+ * compressed num_threads K, multiqueue_uint32, multiqueue_uint64 or multiqueue_float num_threads K,
+ * stealing num_threads K [lag_threshold], prefetch num_threads K group_size, hybrid num_threads K threshold,
+ * phast num_threads, incremental num_threads K batch_size, mst_prim num_threads, mst_boruvka num_threads, or one of
+ * the sequential engines sequential_dary, sequential_radix and sequential_dial */
+class Param {
+public:
+    Param(int num_threads, int size_multiple, std::string queue_layout, std::string element_layout,
+          std::string engine = default_engine)
+            : num_threads(num_threads), size_multiple(size_multiple), queue_layout(std::move(queue_layout)),
+              element_layout(std::move(element_layout)), engine(std::move(engine)) {}
+    int num_threads;
+    int size_multiple;
+    std::string queue_layout;
+    std::string element_layout;
+    std::string engine;
+    std::size_t batch_size = 0;
+    std::size_t group_size = 1;
+    std::size_t parallel_threshold = 0;
+    DistType lag_threshold = DistTraits<DistType>::infinity();
+    std::string get_name() const {
+        if (engine == "incremental") {
+            return engine + " " + std::to_string(num_threads) + " " + std::to_string(size_multiple) + " "
+                   + std::to_string(batch_size);
+        }
+        if (engine == "prefetch") {
+            return engine + " " + std::to_string(num_threads) + " " + std::to_string(size_multiple) + " "
+                   + std::to_string(group_size);
+        }
+        if (engine == "hybrid") {
+            return engine + " " + std::to_string(num_threads) + " " + std::to_string(size_multiple) + " "
+                   + std::to_string(parallel_threshold);
+        }
+        if (engine == "stealing" && lag_threshold != DistTraits<DistType>::infinity()) {
+            return engine + " " + std::to_string(num_threads) + " " + std::to_string(size_multiple) + " "
+                   + std::to_string(lag_threshold);
+        }
+        if (engine == "adaptive" || engine == "compressed" || engine == "stealing" || is_dist_engine(engine)) {
+            return engine + " " + std::to_string(num_threads) + " " + std::to_string(size_multiple);
+        }
+        if (is_sequential_engine(engine)) {
+            return engine;
+        }
+        if (engine != default_engine) {
+            return engine + " " + std::to_string(num_threads);
+        }
+        std::string name = std::to_string(num_threads) + " " + std::to_string(size_multiple);
+        if (queue_layout != default_queue_layout || element_layout != default_element_layout) {
+            name += " " + queue_layout + " " + element_layout;
+        }
+        return name;
+    }
+};
+
+class OutputOptions {
+public:
+    // check compares with this binary answer if it exists, otherwise saves the first answer to it.
+    std::string reference_filename;
+    bool has_reference = false;
+    // If not empty, run and check write each answer to output_prefix + index + (".bin" or ".out").
+    std::string output_prefix;
+    bool binary_output = false;
+    // Return parents from the implementations, verify them, and write them to output_prefix + index + ".parents.bin".
+    bool track_parents = false;
+};
+
+class HarnessOptions {
+public:
+    // Untimed runs of each engine before the timed ones. The first run is verified.
+    std::size_t warmup = 1;
+    std::size_t repetitions = 5;
+    // The results are written here, or to the standard output if it's empty.
+    std::string json_filename;
+    // Results of an earlier run to compare with, if not empty.
+    std::string baseline_filename;
+    // A slowdown is a regression if its p-value is below alpha and the median is slower by more than tolerance.
+    double alpha = 0.05;
+    double tolerance = 0.05;
+};
 
 class Config {
 public:
-    enum RunType { run, check, benchmark };
-    Config(std::vector<std::pair<int, int>> params, AdjList graph, size_t one_queue_reserve_size,
-           RunType run_type, bool run_seq)
-           : params(std::move(params)), graph(std::move(graph)), one_queue_reserve_size(one_queue_reserve_size),
-                                       run_type(run_type), run_seq(run_seq || run_type == check) {}
-    std::vector<std::pair<int, int>> params;
+    enum RunType { run, check, verify, benchmark, harness };
+    Config(std::string input_filename, std::vector<Param> params, AdjList graph, size_t one_queue_reserve_size,
+           RunType run_type, bool run_seq, OutputOptions output_options, HarnessOptions harness_options,
+           std::vector<char*> benchmark_args)
+           : input_filename(std::move(input_filename)), params(std::move(params)), graph(std::move(graph)),
+             one_queue_reserve_size(one_queue_reserve_size), run_type(run_type),
+             run_seq(run_seq || (run_type == check && !output_options.has_reference) || run_type == harness),
+             output_options(std::move(output_options)), harness_options(std::move(harness_options)),
+             benchmark_args(std::move(benchmark_args)) {}
+    // A comma-separated list of inputs for the harness.
+    std::string input_filename;
+    std::vector<Param> params;
     AdjList graph;
     std::size_t one_queue_reserve_size;
     RunType run_type;
     bool run_seq;
+    OutputOptions output_options;
+    HarnessOptions harness_options;
+    std::vector<char*> benchmark_args;
+    // Throughput workloads for mops, default_workloads() if empty.
+    std::vector<Workload> workloads;
 };
 
 static void bm_benchmark(benchmark::State& state, const BindedImpl & impl) {
@@ -30,18 +151,70 @@ static void bm_benchmark(benchmark::State& state, const BindedImpl & impl) {
         (void) _;
         state.PauseTiming();
         Timer ds(&state);
-        impl.first(ds);
+        DistsAndStatistics result = impl.first(ds);
+        if (result.get_num_pops() != 0) {
+            state.counters["pops"] = (double)result.get_num_pops();
+            state.counters["wasted_pops"] = (double)result.get_num_wasted_pops();
+        }
         state.ResumeTiming();
     }
 }
 
-std::vector<std::pair<int, int>> read_params(const std::string & params_filename) {
-    std::vector<std::pair<int, int>> params;
+std::vector<Param> read_params(const std::string & params_filename) {
+    std::vector<Param> params;
     std::ifstream params_input(params_filename);
-    int num_threads;
-    int size_multiple;
-    while (params_input >> num_threads >> size_multiple) {
-        params.emplace_back(num_threads, size_multiple);
+    std::string line;
+    while (std::getline(params_input, line)) {
+        std::istringstream line_input(line);
+        std::string engine;
+        if (line_input >> engine && !std::isdigit((unsigned char)engine[0])) {
+            Param param(0, 1, default_queue_layout, default_element_layout, engine);
+            bool valid;
+            if (is_sequential_engine(engine)) {
+                valid = true;
+            } else if (engine == "phast" || engine == "mst_prim" || engine == "mst_boruvka") {
+                valid = (bool)(line_input >> param.num_threads);
+            } else if (engine == "adaptive" || engine == "compressed" || is_dist_engine(engine)) {
+                valid = (bool)(line_input >> param.num_threads >> param.size_multiple);
+            } else if (engine == "stealing") {
+                valid = (bool)(line_input >> param.num_threads >> param.size_multiple);
+                DistType lag_threshold;
+                if (line_input >> lag_threshold) {
+                    param.lag_threshold = lag_threshold;
+                }
+            } else if (engine == "prefetch") {
+                valid = (bool)(line_input >> param.num_threads >> param.size_multiple >> param.group_size);
+            } else if (engine == "hybrid") {
+                valid = (bool)(line_input >> param.num_threads >> param.size_multiple >> param.parallel_threshold);
+            } else if (engine == "incremental") {
+                valid = (bool)(line_input >> param.num_threads >> param.size_multiple >> param.batch_size);
+            } else {
+                std::cerr << "Unknown engine in params line: " << line << std::endl;
+                exit(1);
+            }
+            if (!valid) {
+                std::cerr << "Missing numbers in params line: " << line << std::endl;
+                exit(1);
+            }
+            params.push_back(param);
+            continue;
+        }
+        line_input.clear();
+        line_input.seekg(0);
+        int num_threads;
+        int size_multiple;
+        if (!(line_input >> num_threads >> size_multiple)) {
+            continue;
+        }
+        std::string queue_layout = default_queue_layout;
+        std::string element_layout = default_element_layout;
+        line_input >> queue_layout >> element_layout;
+        bool known = with_multiqueue_layout(queue_layout, element_layout, [](auto tag) { (void)tag; });
+        if (!known) {
+            std::cerr << "Unknown layout in params line: " << line << std::endl;
+            exit(1);
+        }
+        params.emplace_back(num_threads, size_multiple, queue_layout, element_layout);
     }
     return params;
 }
@@ -76,7 +249,27 @@ AdjList read_edges_into_adj_list(std::istream & istream) {
     return adj_list;
 }
 
+AdjList generate_input(const std::string& spec) {
+    std::cerr << "Generating " << spec << ": ";
+    std::pair<AdjList, std::chrono::milliseconds> p;
+    try {
+        p = measure_time<AdjList>([&spec]() { return generate_graph(spec); });
+    } catch (const std::invalid_argument & e) {
+        std::cerr << e.what() << std::endl;
+        exit(1);
+    }
+    std::size_t num_arcs = 0;
+    for (const auto & edges : p.first) {
+        num_arcs += edges.size();
+    }
+    std::cerr << p.second.count() << " ms, " << p.first.size() << " vertices, " << num_arcs << " arcs" << std::endl;
+    return p.first;
+}
+
 AdjList read_input(const std::string& filename) {
+    if (is_generator_spec(filename)) {
+        return generate_input(filename);
+    }
     std::ifstream input(filename + ".in");
     if (!input.good()) {
         std::cerr << "Input file " + filename + ".in doesn't exist" << std::endl;
@@ -89,15 +282,19 @@ AdjList read_input(const std::string& filename) {
     return p.first;
 }
 
+const int num_mq_args = 6;
+
 void print_usage_error_and_exit() {
     std::cerr << "Usage: ./mq input_filename_no_ext params_filename one_queue_reserve_size run_seq[0,1] "
-                 "[run|check|benchmark]"
+                 "[run|check|verify|benchmark|harness] [--reference=filename] [--output=prefix] [--binary_output] "
+                 "[--parents] [--warmup=n] [--repetitions=n] [--json=filename] [--baseline=filename] [--alpha=p] "
+                 "[--tolerance=fraction] [--workload=spec] [--workloads=filename] [google_benchmark_flags]"
               << std::endl;
     exit(1);
 }
 
 Config process_input(int argc, char** argv) {
-    if (argc != 6) {
+    if (argc < num_mq_args) {
         print_usage_error_and_exit();
     }
     const std::string input_filename(argv[1]);
@@ -109,38 +306,299 @@ Config process_input(int argc, char** argv) {
         run_type = Config::run;
     } else if (strcmp("check", argv[5]) == 0) {
         run_type = Config::check;
+    } else if (strcmp("verify", argv[5]) == 0) {
+        run_type = Config::verify;
     } else if (strcmp("benchmark", argv[5]) == 0) {
         run_type = Config::benchmark;
+    } else if (strcmp("harness", argv[5]) == 0) {
+        run_type = Config::harness;
     } else {
         print_usage_error_and_exit();
     }
 
-    std::vector<std::pair<int, int>> params = read_params(params_filename);
+    OutputOptions output_options;
+    HarnessOptions harness_options;
+    std::vector<Workload> workloads;
+    std::vector<char*> benchmark_args;
+    for (int i = num_mq_args; i < argc; i++) {
+        const std::string arg(argv[i]);
+        const std::string reference_flag = "--reference=";
+        const std::string output_flag = "--output=";
+        auto value_of = [&arg](const std::string & flag) -> const char * {
+            return arg.compare(0, flag.size(), flag) == 0 ? arg.c_str() + flag.size() : nullptr;
+        };
+        if (value_of("--warmup=") != nullptr) {
+            harness_options.warmup = std::stoul(value_of("--warmup="));
+        } else if (value_of("--repetitions=") != nullptr) {
+            harness_options.repetitions = std::max(1UL, std::stoul(value_of("--repetitions=")));
+        } else if (value_of("--json=") != nullptr) {
+            harness_options.json_filename = value_of("--json=");
+        } else if (value_of("--baseline=") != nullptr) {
+            harness_options.baseline_filename = value_of("--baseline=");
+        } else if (value_of("--alpha=") != nullptr) {
+            harness_options.alpha = std::stod(value_of("--alpha="));
+        } else if (value_of("--tolerance=") != nullptr) {
+            harness_options.tolerance = std::stod(value_of("--tolerance="));
+        } else if (value_of("--workload=") != nullptr || value_of("--workloads=") != nullptr) {
+            try {
+                if (value_of("--workload=") != nullptr) {
+                    workloads.push_back(parse_workload(value_of("--workload=")));
+                } else {
+                    std::vector<Workload> from_file = read_workloads(value_of("--workloads="));
+                    workloads.insert(workloads.end(), from_file.begin(), from_file.end());
+                }
+            } catch (const std::invalid_argument & e) {
+                std::cerr << "Bad workload: " << e.what() << std::endl;
+                exit(1);
+            }
+        } else if (arg.compare(0, reference_flag.size(), reference_flag) == 0) {
+            output_options.reference_filename = arg.substr(reference_flag.size());
+            output_options.has_reference = std::ifstream(output_options.reference_filename).good();
+        } else if (arg.compare(0, output_flag.size(), output_flag) == 0) {
+            output_options.output_prefix = arg.substr(output_flag.size());
+        } else if (arg == "--binary_output") {
+            output_options.binary_output = true;
+        } else if (arg == "--parents") {
+            output_options.track_parents = true;
+        } else {
+            benchmark_args.push_back(argv[i]);
+        }
+    }
+
+    std::vector<Param> params = read_params(params_filename);
     AdjList graph;
-    if (input_filename != "mops") {
+    if (input_filename != "mops" && run_type != Config::harness) {
         graph = read_input(input_filename);
     }
-    return Config(params, graph, one_queue_reserve_size, run_type, run_seq);
+    Config config(input_filename, params, graph, one_queue_reserve_size, run_type, run_seq, output_options,
+                  harness_options, benchmark_args);
+    config.workloads = std::move(workloads);
+    return config;
 }
 
-std::vector<Implementation> create_impls(const std::vector<std::pair<int, int>>& params, bool run_seq,
-        size_t one_queue_reserve_size) {
+/* Loads input_filename.ch, or builds the contraction hierarchy and saves it there. Done once, outside of the timing. */
+class CHCache {
+private:
+    std::string filename;
+    std::unique_ptr<ContractionHierarchy> ch;
+public:
+    explicit CHCache(const std::string & input_filename) : filename(input_filename + ".ch") {}
+    const ContractionHierarchy & get(const AdjList & graph) {
+        if (ch && ch->matches(graph)) {
+            return *ch;
+        }
+        ch.reset(new ContractionHierarchy());
+        if (ch->load(filename) && ch->matches(graph)) {
+            return *ch;
+        }
+        std::cerr << "Building contraction hierarchy " << filename << ": ";
+        std::chrono::milliseconds time_ms = measure_time([this, &graph]() {
+            *ch = ContractionHierarchy::build(graph);
+        });
+        std::cerr << time_ms.count() << " ms, " << ch->get_num_levels() << " levels, " << ch->get_num_arcs()
+                  << " arcs" << std::endl;
+        if (!ch->save(filename)) {
+            std::cerr << "Failed to write " << filename << std::endl;
+        }
+        return *ch;
+    }
+};
+
+/* Compresses the loaded graph once, outside of the timing. */
+class CompressedGraphCache {
+private:
+    const AdjList * source = nullptr;
+    CompressedGraph compressed;
+public:
+    const CompressedGraph & get(const AdjList & graph) {
+        if (source == &graph && compressed.size() == graph.size()) {
+            return compressed;
+        }
+        std::cerr << "Compressing the graph: ";
+        std::chrono::milliseconds time_ms = measure_time([this, &graph]() {
+            compressed = CompressedGraph(graph);
+        });
+        std::size_t edges_bytes = 0;
+        for (const auto & edges : graph) {
+            edges_bytes += edges.size() * sizeof(Edge) + sizeof(edges);
+        }
+        std::cerr << time_ms.count() << " ms, " << compressed.get_num_bytes() << " bytes instead of " << edges_bytes
+                  << std::endl;
+        source = &graph;
+        return compressed;
+    }
+};
+
+/* Copies the loaded graph to a CompactGraph once, outside of the timing. */
+class CompactGraphCache {
+private:
+    const AdjList * source = nullptr;
+    CompactGraph compact;
+public:
+    const CompactGraph & get(const AdjList & graph) {
+        if (source == &graph && compact.size() == graph.size()) {
+            return compact;
+        }
+        try {
+            compact = CompactGraph(graph);
+        } catch (const std::invalid_argument & e) {
+            std::cerr << "Can't make a compact graph: " << e.what() << std::endl;
+            exit(1);
+        }
+        source = &graph;
+        return compact;
+    }
+};
+
+std::vector<Implementation> create_impls(const std::vector<Param>& params, bool run_seq,
+        size_t one_queue_reserve_size, bool track_parents, const std::string & input_filename) {
     std::vector<Implementation> impls;
+    auto ch_cache = std::make_shared<CHCache>(input_filename);
+    auto compressed_cache = std::make_shared<CompressedGraphCache>();
+    auto compact_cache = std::make_shared<CompactGraphCache>();
     if (run_seq) {
-        auto sequential_dijkstra = [](const AdjList &graph, Timer& state) {
-            return calc_dijkstra_sequential(graph, state);
+        auto sequential_dijkstra = [track_parents](const AdjList &graph, Timer& state) {
+            return calc_dijkstra_sequential(graph, state, track_parents);
         };
         impls.emplace_back(sequential_dijkstra, "Sequential");
     }
     for (const auto & param: params) {
-        int num_threads = param.first;
-        int size_multiple = param.second;
-        std::string impl_name = std::to_string(num_threads) + " " + std::to_string(size_multiple);
-        impls.emplace_back(
-                [num_threads, size_multiple, one_queue_reserve_size] (const AdjList & graph, Timer& state) {
-                    return calc_dijkstra(graph, num_threads, size_multiple, one_queue_reserve_size, state);
-                },
-                impl_name);
+        int num_threads = param.num_threads;
+        int size_multiple = param.size_multiple;
+        if (param.engine == "mst_prim" || param.engine == "mst_boruvka") {
+            continue;
+        }
+        if (is_sequential_engine(param.engine)) {
+            auto engine = param.engine == "sequential_dary" ? &calc_dijkstra_dary
+                          : (param.engine == "sequential_radix" ? &calc_dijkstra_radix : &calc_dijkstra_dial);
+            impls.emplace_back([compact_cache, engine, track_parents](const AdjList & graph, Timer& state) {
+                const CompactGraph & compact = compact_cache->get(graph);
+                try {
+                    return engine(compact, state, track_parents);
+                } catch (const std::invalid_argument & e) {
+                    std::cerr << e.what() << std::endl;
+                    exit(1);
+                }
+            }, param.get_name());
+            continue;
+        }
+        if (param.engine == "phast") {
+            impls.emplace_back([ch_cache, num_threads](const AdjList & graph, Timer& state) {
+                const ContractionHierarchy & ch = ch_cache->get(graph);
+                return DistsAndStatistics(ch.distances_from(0, num_threads, state));
+            }, param.get_name());
+            continue;
+        }
+        if (param.engine == "adaptive") {
+            impls.emplace_back([num_threads, size_multiple, one_queue_reserve_size, track_parents]
+                               (const AdjList & graph, Timer& state) {
+                return calc_dijkstra<AdaptiveMultiqueue>(graph, num_threads, size_multiple, one_queue_reserve_size,
+                                                         state, track_parents);
+            }, param.get_name());
+            continue;
+        }
+        if (param.engine == "stealing") {
+            DistType lag_threshold = param.lag_threshold;
+            impls.emplace_back([num_threads, size_multiple, one_queue_reserve_size, track_parents, lag_threshold]
+                               (const AdjList & graph, Timer& state) {
+                StealingQueue queue(num_threads, size_multiple, one_queue_reserve_size);
+                queue.set_lag_threshold(lag_threshold);
+                return calc_dijkstra(graph, queue, num_threads, state, track_parents);
+            }, param.get_name());
+            continue;
+        }
+        if (param.engine == "prefetch") {
+            std::size_t group_size = param.group_size;
+            impls.emplace_back([num_threads, size_multiple, one_queue_reserve_size, track_parents, group_size]
+                               (const AdjList & graph, Timer& state) {
+                Multiqueue queue(num_threads, size_multiple, one_queue_reserve_size);
+                return calc_dijkstra(graph, queue, num_threads, state, track_parents, group_size);
+            }, param.get_name());
+            continue;
+        }
+        if (param.engine == "hybrid") {
+            std::size_t parallel_threshold = param.parallel_threshold;
+            impls.emplace_back([num_threads, size_multiple, one_queue_reserve_size, track_parents, parallel_threshold]
+                               (const AdjList & graph, Timer& state) {
+                return calc_dijkstra_hybrid(graph, num_threads, size_multiple, one_queue_reserve_size,
+                                            parallel_threshold, state, track_parents);
+            }, param.get_name());
+            continue;
+        }
+        if (param.engine == "compressed") {
+            impls.emplace_back([compressed_cache, num_threads, size_multiple, one_queue_reserve_size, track_parents]
+                               (const AdjList & graph, Timer& state) {
+                return calc_dijkstra(compressed_cache->get(graph), num_threads, size_multiple, one_queue_reserve_size,
+                                     state, track_parents);
+            }, param.get_name());
+            continue;
+        }
+        if (is_dist_engine(param.engine)) {
+            auto add_impl = [&impls, &param, num_threads, size_multiple, one_queue_reserve_size, track_parents]
+                            (auto tag) {
+                using Queue = DistMultiqueue<typename decltype(tag)::type>;
+                impls.emplace_back([num_threads, size_multiple, one_queue_reserve_size, track_parents]
+                                   (const AdjList & graph, Timer& state) {
+                    return calc_dijkstra<Queue>(graph, num_threads, size_multiple, one_queue_reserve_size, state,
+                                                track_parents);
+                }, param.get_name());
+            };
+            if (param.engine == "multiqueue_uint32") {
+                add_impl(LayoutTag<uint32_t>());
+            } else if (param.engine == "multiqueue_uint64") {
+                add_impl(LayoutTag<uint64_t>());
+            } else {
+                add_impl(LayoutTag<float>());
+            }
+            continue;
+        }
+        if (param.engine == "incremental") {
+            // The batch and its reversal are timed, so that the answer is for the loaded graph.
+            std::size_t batch_size = param.batch_size;
+            impls.emplace_back([num_threads, size_multiple, one_queue_reserve_size, track_parents, batch_size]
+                               (const AdjList & graph, Timer& state) {
+                IncrementalDijkstra<> dijkstra(graph, num_threads, size_multiple, one_queue_reserve_size);
+                std::vector<EdgeWeightChange> changes = random_weight_changes(graph, batch_size, 1);
+                dijkstra.update(changes, state);
+                dijkstra.update(reverted_weight_changes(graph, changes), state);
+                if (!track_parents) {
+                    return DistsAndStatistics(dijkstra.get_dists());
+                }
+                return DistsAndStatistics(dijkstra.get_dists(), dijkstra.get_parents());
+            }, param.get_name());
+            continue;
+        }
+        with_multiqueue_layout(param.queue_layout, param.element_layout,
+                [&impls, &param, num_threads, size_multiple, one_queue_reserve_size, track_parents](auto tag) {
+            using Queue = typename decltype(tag)::type;
+            impls.emplace_back(
+                    [num_threads, size_multiple, one_queue_reserve_size, track_parents]
+                    (const AdjList & graph, Timer& state) {
+                        return calc_dijkstra<Queue>(graph, num_threads, size_multiple, one_queue_reserve_size, state,
+                                                    track_parents);
+                    },
+                    param.get_name());
+        });
+    }
+    return impls;
+}
+
+std::vector<MSTImplementation> create_mst_impls(const std::vector<Param>& params, bool run_seq) {
+    std::vector<MSTImplementation> impls;
+    for (const auto & param : params) {
+        std::size_t num_threads = param.num_threads;
+        if (param.engine == "mst_prim") {
+            impls.emplace_back([num_threads](const AdjList & graph, Timer & state) {
+                return calc_mst_prim(graph, num_threads, state);
+            }, param.get_name());
+        } else if (param.engine == "mst_boruvka") {
+            impls.emplace_back([num_threads](const AdjList & graph, Timer & state) {
+                return calc_mst_boruvka(graph, num_threads, state);
+            }, param.get_name());
+        }
+    }
+    if (run_seq && !impls.empty()) {
+        impls.insert(impls.begin(), {&calc_mst_kruskal, "Kruskal"});
     }
     return impls;
 }
@@ -155,6 +613,11 @@ std::vector<BindedImpl> bind_impls(const std::vector<Implementation>& impls, con
 }
 
 bool are_mismatched(const DistVector & correct_answer, const DistVector & to_check) {
+    if (correct_answer.size() != to_check.size()) {
+        std::cerr << "Mismatch: " << to_check.size() << " distances != " << correct_answer.size()
+                << " distances in the reference" << std::endl;
+        return true;
+    }
     auto mismatch = std::mismatch(correct_answer.begin(), correct_answer.end(), to_check.begin());
     if (mismatch.first != correct_answer.end()) {
         std::cerr << "Mismatch: " << *mismatch.second << " != " << *mismatch.first << " at i = "
@@ -164,28 +627,87 @@ bool are_mismatched(const DistVector & correct_answer, const DistVector & to_che
     return false;
 }
 
-void write_answer(std::ostream & ostream, const DistVector & dists) {
-    for (DistType dist : dists) {
-        ostream << dist << '\n';
+/* Writes answers in background threads, so that writing overlaps with the next run. */
+class AnswerWriter {
+private:
+    std::vector<std::future<void>> pending;
+public:
+    AnswerWriter() = default;
+    AnswerWriter(const AnswerWriter & o) = delete;
+    AnswerWriter& operator=(const AnswerWriter & o) = delete;
+    ~AnswerWriter() {
+        wait();
+    }
+    void write(std::string filename, DistVector dists, bool binary) {
+        pending.push_back(std::async(std::launch::async,
+                [filename = std::move(filename), dists = std::move(dists), binary]() {
+            bool written = binary ? write_answer_binary(filename, dists) : write_answer_text(filename, dists);
+            if (!written) {
+                std::cerr << "Failed to write " << filename << std::endl;
+            }
+        }));
+    }
+    void write_parents(std::string filename, ParentVector parents) {
+        pending.push_back(std::async(std::launch::async,
+                [filename = std::move(filename), parents = std::move(parents)]() {
+            if (!write_answer_binary(filename, parents)) {
+                std::cerr << "Failed to write " << filename << std::endl;
+            }
+        }));
+    }
+    void wait() {
+        for (auto & future : pending) {
+            future.get();
+        }
+        pending.clear();
+    }
+};
+
+void write_output(AnswerWriter & writer, const OutputOptions & output_options, std::size_t i,
+                  const DistsAndStatistics & answer) {
+    if (output_options.output_prefix.empty()) {
+        return;
+    }
+    std::string extension = output_options.binary_output ? ".bin" : ".out";
+    writer.write(output_options.output_prefix + std::to_string(i) + extension, answer.get_dists(),
+                 output_options.binary_output);
+    if (!answer.get_parents().empty()) {
+        writer.write_parents(output_options.output_prefix + std::to_string(i) + ".parents.bin", answer.get_parents());
     }
-    ostream << '\n';
 }
 
-void run(const std::vector<BindedImpl>& impls) {
-    for (auto & impl : impls) {
-        const auto & f = impl.first;
+void run(const std::vector<BindedImpl>& impls, const OutputOptions & output_options) {
+    AnswerWriter writer;
+    for (std::size_t i = 0; i < impls.size(); i++) {
+        const auto & f = impls[i].first;
 
         Timer ds;
         auto p = measure_time<DistsAndStatistics>([&f, &ds] { return f(ds); });
         auto time_ms = p.second;
 
         std::cerr << ds.get_total().count() << std::endl;
+        write_output(writer, output_options, i, p.first);
     }
 }
 
-/* The first implementation should be the reference implementation (sequential). */
-void run_and_check(std::vector<BindedImpl> impls) {
+/* Without a reference answer, the first implementation should be the reference implementation (sequential).
+ * A reference read from a file must have a distance for each of the num_vertexes vertices. */
+void run_and_check(std::vector<BindedImpl> impls, std::size_t num_vertexes, const OutputOptions & output_options) {
+    AnswerWriter writer;
     DistVector correct_answer;
+    bool has_correct_answer = false;
+    if (output_options.has_reference) {
+        has_correct_answer = read_answer_binary(output_options.reference_filename, correct_answer);
+        if (!has_correct_answer) {
+            std::cerr << "Reference " << output_options.reference_filename << " is not a binary answer" << std::endl;
+            exit(1);
+        }
+        if (correct_answer.size() != num_vertexes) {
+            std::cerr << "Reference " << output_options.reference_filename << " has " << correct_answer.size()
+                      << " distances, the graph has " << num_vertexes << " vertices" << std::endl;
+            exit(1);
+        }
+    }
     for (std::size_t i = 0; i < impls.size(); i++) {
         const auto & f = impls[i].first;
         const auto & impl_name = impls[i].second;
@@ -199,116 +721,320 @@ void run_and_check(std::vector<BindedImpl> impls) {
         const DistVector &dists = dists_and_statistics.get_dists();
 
         bool mismatched = false;
-        if (i == 0) {
+        if (!has_correct_answer) {
             correct_answer = dists;
+            has_correct_answer = true;
+            if (!output_options.reference_filename.empty()) {
+                writer.write(output_options.reference_filename, correct_answer, true);
+            }
         } else {
             mismatched = are_mismatched(correct_answer, dists);
         }
 
         if (mismatched) {
-            std::ofstream output(impl_name + ".out" + std::to_string(i));
-            std::chrono::milliseconds elapsed = measure_time([&output, &dists]() { write_answer(output, dists); });
+            writer.write(impl_name + ".out" + std::to_string(i), dists, false);
         }
+        write_output(writer, output_options, i, dists_and_statistics);
     }
 }
 
-void ops_thread_routine(Multiqueue & q, boost::barrier & barrier, uint64_t & num_ops, int thread_id, bool monotonic) {
-    const int max_value = monotonic ? 100 : (int)1e8;
-    const auto max_elements = (std::size_t)1e7;
+/* Checks each answer with verify_dists instead of comparing it with the sequential one. Returns false on failure. */
+bool run_and_verify(const std::vector<BindedImpl>& impls, const AdjList & graph, const OutputOptions & output_options) {
+    AnswerWriter writer;
+    bool all_ok = true;
+    for (std::size_t i = 0; i < impls.size(); i++) {
+        const auto & f = impls[i].first;
+        const auto & impl_name = impls[i].second;
+
+        Timer ds;
+        DistsAndStatistics dists_and_statistics = f(ds);
+        const DistVector & dists = dists_and_statistics.get_dists();
+        const ParentVector & parents = dists_and_statistics.get_parents();
+        VerificationResult result;
+        std::chrono::milliseconds verification_time = measure_time([&result, &graph, &dists, &parents]() {
+            result = verify_dists(graph, dists, 0);
+            if (result.ok && !parents.empty()) {
+                result = verify_parents(graph, dists, parents, 0);
+            }
+        });
+
+        std::cerr << impl_name << ": " << ds.get_total().count() << " ms, ";
+        if (dists_and_statistics.get_num_pops() != 0) {
+            std::cerr << dists_and_statistics.get_num_pops() << " pops ("
+                      << dists_and_statistics.get_num_wasted_pops() << " wasted), ";
+        }
+        std::cerr << "verified in "
+                  << verification_time.count() << " ms: " << (result.ok ? "OK" : result.error) << std::endl;
+        all_ok = all_ok && result.ok;
+        write_output(writer, output_options, i, dists_and_statistics);
+    }
+    return all_ok;
+}
 
-    std::default_random_engine generator{std::random_device()()};
-    std::uniform_int_distribution<int> distribution(1, max_value);
-    auto dice = [&distribution, &generator] { return distribution(generator); };
-    std::vector<QueueElement> elements(max_elements);
-    std::vector<int> random_ints(max_elements);
-    for (int & random_int: random_ints) {
-        random_int = dice();
+/* Runs the MST engines on the undirected graph. check and verify compare each answer with Kruskal's and return false
+ * on a mismatch. */
+bool run_mst(const std::vector<MSTImplementation>& impls, const AdjList & graph, Config::RunType run_type) {
+    bool compare = run_type == Config::check || run_type == Config::verify;
+    MSTResult expected;
+    if (compare) {
+        Timer ds;
+        expected = calc_mst_kruskal(graph, ds);
+    }
+    bool all_ok = true;
+    for (const auto & impl : impls) {
+        Timer ds;
+        MSTResult result = impl.first(graph, ds);
+        std::cerr << impl.second << ": " << ds.get_total().count() << " ms, total weight " << result.total_weight
+                  << ", " << result.num_edges << " edges";
+        if (compare) {
+            bool ok = result == expected;
+            std::cerr << (ok ? ": OK" : ": Mismatch with Kruskal, total weight " + std::to_string(expected.total_weight)
+                                        + ", " + std::to_string(expected.num_edges) + " edges");
+            all_ok = all_ok && ok;
+        }
+        std::cerr << std::endl;
     }
+    return all_ok;
+}
 
-    barrier.wait();
-    auto start = std::chrono::steady_clock::now();
-    int subticks = 1000;
-    for (size_t i = 0; i < elements.size(); i++) {
-        for (int j = 0; j < subticks; i++, j++) {
-            QueueElement* element = q.pop();
-            if (element == &empty_element) {
-                std::cerr << "WRONG results: empty element reached" << std::endl;
-                exit(1);
+/* The Sequential, the tuned sequential and the Kruskal engines, which run on the calling thread. */
+bool is_sequential_impl(const std::string & name) {
+    return name == "Sequential" || name == "Kruskal" || is_sequential_engine(name);
+}
+
+/* Times one engine: warmup runs, the first of them checked with check_answer, then the repetitions. The sequential
+ * engines run pinned to the first CPU, the parallel ones pin their own threads. */
+HarnessResult time_harness_impl(const std::string & graph_name, const std::string & name,
+                                const std::function<bool(Timer &, bool)> & run_once,
+                                const HarnessOptions & options) {
+    HarnessResult result;
+    result.graph = graph_name;
+    result.engine = name;
+    bool pinned = is_sequential_impl(name);
+    cpu_set_t affinity;
+    if (pinned) {
+        affinity = pin_current_thread(0);
+    }
+    for (std::size_t i = 0; i < options.warmup + options.repetitions; i++) {
+        Timer timer;
+        bool ok = run_once(timer, i == 0);
+        result.ok = result.ok && ok;
+        if (i >= options.warmup) {
+            result.times_ms.push_back((double)timer.get_total_microseconds().count() / 1000);
+        }
+    }
+    if (pinned) {
+        set_current_thread_affinity(affinity);
+    }
+    return result;
+}
+
+/* Runs every engine of the params on each graph of the comma-separated input list, writes the results as JSON and
+ * compares them with the baseline. Returns false if an answer was wrong or a regression was found. */
+bool run_harness(const Config & config) {
+    const HarnessOptions & options = config.harness_options;
+    HostTopology host = HostTopology::detect();
+    std::vector<HarnessResult> results;
+    std::istringstream inputs(config.input_filename);
+    std::string input_filename;
+    while (std::getline(inputs, input_filename, ',')) {
+        AdjList graph = read_input(input_filename);
+        auto impls = create_impls(config.params, true, config.one_queue_reserve_size, false, input_filename);
+        auto mst_impls = create_mst_impls(config.params, true);
+        std::size_t first_result = results.size();
+        for (const auto & impl : impls) {
+            const auto & f = impl.first;
+            results.push_back(time_harness_impl(input_filename, impl.second, [&f, &graph](Timer & timer, bool check) {
+                DistsAndStatistics answer = f(graph, timer);
+                return !check || verify_dists(graph, answer.get_dists(), 0).ok;
+            }, options));
+        }
+        AdjList undirected;
+        if (!mst_impls.empty()) {
+            undirected = make_undirected(graph);
+        }
+        MSTResult expected_mst;
+        for (const auto & impl : mst_impls) {
+            const auto & f = impl.first;
+            bool reference = is_sequential_impl(impl.second);
+            results.push_back(time_harness_impl(input_filename, impl.second,
+                    [&f, &undirected, &expected_mst, reference](Timer & timer, bool check) {
+                MSTResult answer = f(undirected, timer);
+                if (reference && check) {
+                    expected_mst = answer;
+                }
+                return !check || answer == expected_mst;
+            }, options));
+        }
+
+        // The shortest paths engines come first, then the MST ones. Each is compared with the fastest sequential one.
+        std::size_t first_mst_result = first_result + impls.size();
+        auto fastest_sequential = [&results](std::size_t begin, std::size_t end) {
+            std::size_t fastest = end;
+            for (std::size_t j = begin; j < end; j++) {
+                if (is_sequential_impl(results[j].engine)
+                        && (fastest == end || results[j].get_median_ms() < results[fastest].get_median_ms())) {
+                    fastest = j;
+                }
+            }
+            return fastest;
+        };
+        std::size_t fastest_shortest_paths = fastest_sequential(first_result, first_mst_result);
+        std::size_t fastest_mst = fastest_sequential(first_mst_result, results.size());
+        for (std::size_t i = first_result; i < results.size(); i++) {
+            HarnessResult & result = results[i];
+            std::size_t reference = i < first_mst_result ? fastest_shortest_paths : fastest_mst;
+            result.speedup_over = results[reference].engine;
+            if (result.get_median_ms() > 0) {
+                result.speedup = results[reference].get_median_ms() / result.get_median_ms();
             }
-            int new_dist = random_ints[i] + (monotonic ? element->get_dist() : 0);
-            q.push(&elements[i], new_dist);
-            num_ops += 2;
+            std::pair<double, double> interval = median_confidence_interval(result.times_ms);
+            std::cerr << result.graph << " / " << result.engine << ": " << result.get_median_ms() << " ms ["
+                      << interval.first << ", " << interval.second << "], " << result.speedup << "x "
+                      << result.speedup_over << (result.ok ? "" : ", WRONG ANSWER") << std::endl;
         }
-        auto end = std::chrono::steady_clock::now();
-        if (std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() > 1000) {
-            break;
+    }
+
+    std::ostringstream config_json;
+    config_json << "{\"inputs\": \"" << json_escape(config.input_filename) << "\", \"reserve\": "
+                << config.one_queue_reserve_size << ", \"warmup\": " << options.warmup << ", \"repetitions\": "
+                << options.repetitions << "}";
+    if (options.json_filename.empty()) {
+        write_harness_json(std::cout, host, config_json.str(), results);
+    } else {
+        std::ofstream output(options.json_filename);
+        write_harness_json(output, host, config_json.str(), results);
+        if (!output) {
+            std::cerr << "Failed to write " << options.json_filename << std::endl;
         }
     }
-    if (thread_id == 0 && num_ops == elements.size() * 2) {
-        std::cerr << "WRONG results: Ran out of elements before time is up" << std::endl;
+
+    bool ok = std::all_of(results.begin(), results.end(), [](const HarnessResult & result) { return result.ok; });
+    if (options.baseline_filename.empty()) {
+        return ok;
+    }
+    std::ifstream baseline_input(options.baseline_filename);
+    HostTopology baseline_host;
+    std::vector<HarnessResult> baseline;
+    if (!read_harness_json(baseline_input, baseline_host, baseline)) {
+        std::cerr << "Baseline " << options.baseline_filename << " has no harness results" << std::endl;
+        return false;
+    }
+    if (baseline_host.cpu_model != host.cpu_model || baseline_host.hardware_threads != host.hardware_threads) {
+        std::cerr << "Warning: the baseline was measured on another host (" << baseline_host.cpu_model << ", "
+                  << baseline_host.hardware_threads << " threads)" << std::endl;
+    }
+    std::size_t num_regressions = 0;
+    for (const HarnessComparison & comparison : compare_with_baseline(baseline, results, options.alpha,
+                                                                      options.tolerance)) {
+        double change = comparison.current_median_ms / comparison.baseline_median_ms - 1;
+        std::cerr << (comparison.regression ? "REGRESSION " : "") << comparison.graph << " / " << comparison.engine
+                  << ": " << comparison.baseline_median_ms << " -> " << comparison.current_median_ms << " ms ("
+                  << std::showpos << change * 100 << std::noshowpos << "%, p = " << comparison.p_value << ")"
+                  << std::endl;
+        num_regressions += comparison.regression ? 1 : 0;
+    }
+    if (num_regressions > 0) {
+        std::cerr << num_regressions << " regressions against " << options.baseline_filename << std::endl;
+        return false;
+    }
+    return ok;
+}
+
+static void bm_mst(benchmark::State& state, const MSTImplementation & impl, const AdjList & graph) {
+    for (auto _ : state) {
+        (void) _;
+        state.PauseTiming();
+        Timer ds(&state);
+        impl.first(graph, ds);
+        state.ResumeTiming();
+    }
+}
+
+static void bm_throughput(benchmark::State& state, const Param & param, const Workload & workload) {
+    for (auto _ : state) {
+        (void) _;
+        ThroughputResult result;
+        if (param.engine == "adaptive") {
+            result = run_throughput<AdaptiveMultiqueue>(param.num_threads, param.size_multiple, workload);
+        } else if (param.engine == "stealing") {
+            result = run_throughput<StealingQueue>(param.num_threads, param.size_multiple, workload);
+        } else {
+            with_multiqueue_layout(param.queue_layout, param.element_layout, [&param, &workload, &result](auto tag) {
+                using Queue = typename decltype(tag)::type;
+                result = run_throughput<Queue>(param.num_threads, param.size_multiple, workload);
+            });
+        }
+        state.SetIterationTime(result.get_seconds());
+        state.counters["Mops"] = result.get_mops();
+        state.counters["ops_per_thread"] = result.get_mean_ops_per_thread();
+        state.counters["ops_per_thread_cv"] = result.get_cv_ops_per_thread();
+        state.counters["empty_pops"] = (double)result.empty_pops;
+        state.counters["stalls"] = (double)result.stalls;
     }
-    barrier.wait();
 }
 
-uint64_t throughput_benchmark(std::size_t num_threads, std::size_t size_multiple, bool monotonic) {
-    const auto init_size = (std::size_t)1e6;
-    const auto max_value = (std::size_t)1e8;
-    const std::size_t  num_binheaps = num_threads * size_multiple;
-    const auto one_queue_reserve_size = init_size / num_binheaps + 1'000;
-//    std::cerr << "one_queue_reserve_size " << one_queue_reserve_size << std::endl;
-
-    std::default_random_engine generator{std::random_device()()};
-    std::uniform_int_distribution<int> distribution(0, max_value);
-    auto dice = [&distribution, &generator] { return distribution(generator); };
-
-    Multiqueue q(num_threads, size_multiple, one_queue_reserve_size);
-    std::vector<QueueElement> init_elements(init_size);
-    for (auto & init_element : init_elements) {
-        q.push(&init_element, dice());
-    }
-    std::vector<uint64_t> num_ops_counters(num_threads);
-    std::vector<std::thread> threads;
-    boost::barrier barrier(num_threads);
-    for (std::size_t thread_id = 0; thread_id < num_threads; thread_id++) {
-        threads.emplace_back(ops_thread_routine, std::ref(q), std::ref(barrier),
-                std::ref(num_ops_counters[thread_id]), thread_id, monotonic);
-        pin_thread(thread_id, threads.back());
-    }
-    for (std::thread & thread : threads) {
-        thread.join();
-    }
-    return std::accumulate(num_ops_counters.begin(), num_ops_counters.end(), 0ULL);
+/* Google Benchmark gets the arguments following the mq arguments, e.g. --benchmark_filter=uniform */
+void run_google_benchmark(char* argv0, const std::vector<char*> & benchmark_args) {
+    std::vector<char*> benchmark_argv = {argv0};
+    benchmark_argv.insert(benchmark_argv.end(), benchmark_args.begin(), benchmark_args.end());
+    int benchmark_argc = (int)benchmark_argv.size();
+    benchmark::Initialize(&benchmark_argc, benchmark_argv.data());
+    benchmark::RunSpecifiedBenchmarks();
 }
 
 int main(int argc, char** argv) {
     Config config = process_input(argc, argv);
-    if (config.graph.empty()) {
-        std::cerr << "mops" << std::endl;
-        const int num_runs = 3;
-        for (auto & param: config.params) {
-            uint64_t sum = 0;
-            for (int i = 0; i < num_runs; i++) {
-                uint64_t mops = throughput_benchmark(param.first, param.second, false);
-                sum += mops;
+    if (config.run_type == Config::harness) {
+        return run_harness(config) ? 0 : 1;
+    }
+    if (config.input_filename == "mops") {
+        const auto workloads = config.workloads.empty() ? default_workloads() : config.workloads;
+        for (const auto & param : config.params) {
+            if (param.engine != default_engine && param.engine != "adaptive" && param.engine != "stealing") {
+                continue;
+            }
+            for (const auto & workload : workloads) {
+                std::string name = param.get_name() + "/" + workload.name;
+                benchmark::RegisterBenchmark(name.c_str(), &bm_throughput, param, workload)
+                        ->Unit(benchmark::kMillisecond)->UseManualTime()->Iterations(1)->Repetitions(3);
             }
-            sum /= num_runs;
-            std::cerr << sum / 1'000'000 << std::endl;
         }
+        run_google_benchmark(argv[0], config.benchmark_args);
         return 0;
     }
-    auto impls = create_impls(config.params, config.run_seq, config.one_queue_reserve_size);
+    auto impls = create_impls(config.params, config.run_seq, config.one_queue_reserve_size,
+                              config.output_options.track_parents, config.input_filename);
     auto binded_impls = bind_impls(impls, config.graph);
+    auto mst_impls = create_mst_impls(config.params, config.run_seq);
+    AdjList undirected;
+    if (!mst_impls.empty()) {
+        std::chrono::milliseconds time_ms = measure_time([&undirected, &config]() {
+            undirected = make_undirected(config.graph);
+        });
+        std::cerr << "Making the graph undirected: " << time_ms.count() << " ms" << std::endl;
+    }
+    bool mst_ok = true;
     if (config.run_type == Config::run) {
-        run(binded_impls);
+        run(binded_impls, config.output_options);
+        run_mst(mst_impls, undirected, config.run_type);
     } else if (config.run_type == Config::check) {
-        run_and_check(binded_impls);
+        run_and_check(binded_impls, config.graph.size(), config.output_options);
+        mst_ok = run_mst(mst_impls, undirected, config.run_type);
+    } else if (config.run_type == Config::verify) {
+        bool ok = run_and_verify(binded_impls, config.graph, config.output_options);
+        mst_ok = run_mst(mst_impls, undirected, config.run_type);
+        return ok && mst_ok ? 0 : 1;
     } else {
         for (const auto & impl : binded_impls) {
             benchmark::RegisterBenchmark(impl.second.c_str(), &bm_benchmark, impl)->Unit(benchmark::kMillisecond)
                     ->MeasureProcessCPUTime()->Iterations(3);
         }
-        int pseudo_argc = 1;
-        benchmark::Initialize(&pseudo_argc, argv);
-        benchmark::RunSpecifiedBenchmarks();
+        for (const auto & impl : mst_impls) {
+            benchmark::RegisterBenchmark(impl.second.c_str(), &bm_mst, impl, std::cref(undirected))
+                    ->Unit(benchmark::kMillisecond)->MeasureProcessCPUTime()->Iterations(3);
+        }
+        run_google_benchmark(argv[0], config.benchmark_args);
     }
+    return mst_ok ? 0 : 1;
 }
@@ -2,14 +2,40 @@
 #define MULTIQUEUE_BINARY_HEAP_H
 
 #include <atomic>
+#include <cstdint>
 #include <unordered_map>
 #include <vector>
 #include <limits>
 #include <mutex>
 #include <thread>
+#include <type_traits>
 
 using Vertex = std::size_t;
+// The distance type of the input graphs and answers. Queue elements and the Dijkstra engines take others, see DistTraits.
 using DistType = int;
+// Parents of vertices are stored as 32-bit ids to keep QueueElement and the returned parent array small.
+using CompactVertex = std::uint32_t;
+
+const CompactVertex no_parent = std::numeric_limits<CompactVertex>::max();
+
+// Unreachable vertices have infinity, the largest value of Dist. add saturates at infinity instead of overflowing, and
+// compiles to an add and a conditional move, without a branch. Distances are non-negative.
+template<class Dist>
+struct DistTraits {
+    static constexpr Dist infinity() {
+        return std::numeric_limits<Dist>::has_infinity ? std::numeric_limits<Dist>::infinity()
+                                                       : std::numeric_limits<Dist>::max();
+    }
+    static Dist add(Dist a, Dist b) {
+        if constexpr (std::is_floating_point<Dist>::value) {
+            return a + b;
+        } else {
+            Dist sum;
+            bool overflow = __builtin_add_overflow(a, b, &sum);
+            return overflow ? infinity() : sum;
+        }
+    }
+};
 
 class Spinlock {
 private:
@@ -18,77 +44,117 @@ public:
     void lock() {
         while (spinlock.test_and_set(std::memory_order_acquire));
     }
+    bool try_lock() {
+        return !spinlock.test_and_set(std::memory_order_acquire);
+    }
     void unlock() {
         spinlock.clear(std::memory_order_release);
     }
 };
 
-class QueueElement {
+// QueueElement layouts. The layout is a base class, so a padding precedes the element's fields and separates them
+// from the fields of the previous element in a vector.
+template<std::size_t padding_size>
+struct element_padded {
+    volatile char padding[padding_size]{};
+};
+
+template<std::size_t alignment>
+struct alignas(alignment) element_aligned {};
+
+struct element_not_padded {};
+
+template<class Layout = element_padded<128>, class Dist = DistType>
+class BasicQueueElement : private Layout {
 private:
-    volatile char padding[128]{};
-    std::atomic<DistType> dist;
+    std::atomic<Dist> dist;
     std::atomic<int> q_id;
     Spinlock empty_q_id_spinlock;  // lock when changing q_id from empty to something
+    std::atomic<CompactVertex> parent;  // changed together with dist, under the same lock
 public:
+    using dist_type = Dist;
     size_t index{};
     Vertex vertex;
-    explicit QueueElement(Vertex vertex = 0, DistType dist = std::numeric_limits<DistType>::max()) : dist(dist), q_id(-1), vertex(vertex) {}
-    QueueElement(const QueueElement & o) : dist(o.dist.load()), q_id(o.q_id.load()), vertex(o.vertex) {}
+    static const BasicQueueElement empty_element;
+    explicit BasicQueueElement(Vertex vertex = 0, Dist dist = DistTraits<Dist>::infinity()) : dist(dist), q_id(-1), parent(no_parent), vertex(vertex) {}
+    BasicQueueElement(const BasicQueueElement & o) : Layout(), dist(o.dist.load()), q_id(o.q_id.load()), parent(o.parent.load()), vertex(o.vertex) {}
     void empty_q_id_lock() {
         empty_q_id_spinlock.lock();
     }
     void empty_q_id_unlock() {
         empty_q_id_spinlock.unlock();
     }
-    [[noreturn]] QueueElement & operator=(const QueueElement & o) {
+    [[noreturn]] BasicQueueElement & operator=(const BasicQueueElement & o) {
         (void)o;
         throw std::logic_error("QueueElement.= shouldn't be used. Probably, BinHeap max size is exceeded.");
     }
-    DistType get_dist() const {
+    Dist get_dist() const {
         return dist.load();
     }
-    void set_dist_relaxed(DistType new_dist) {
+    void set_dist_relaxed(Dist new_dist) {
         dist.store(new_dist, std::memory_order_relaxed);
     }
-    DistType get_dist_relaxed() const {
+    Dist get_dist_relaxed() const {
         return dist.load(std::memory_order_relaxed);
     }
+    CompactVertex get_parent_relaxed() const {
+        return parent.load(std::memory_order_relaxed);
+    }
+    void set_parent_relaxed(CompactVertex new_parent) {
+        parent.store(new_parent, std::memory_order_relaxed);
+    }
     int get_q_id_relaxed() const {
         return q_id.load(std::memory_order_relaxed);
     }
     void set_q_id_relaxed(int new_q_id) {
         q_id.store(new_q_id, std::memory_order_relaxed);
     }
-    bool operator==(const QueueElement & o) const {
+    // A pop releases the element with q_id -1, and a push acquires it, as they hold locks of different heaps.
+    int get_q_id_acquire() const {
+        return q_id.load(std::memory_order_acquire);
+    }
+    void set_q_id_release(int new_q_id) {
+        q_id.store(new_q_id, std::memory_order_release);
+    }
+    bool operator==(const BasicQueueElement & o) const {
         return o.vertex == vertex && o.get_dist() == get_dist();
     }
-    bool operator!=(const QueueElement & o) const {
+    bool operator!=(const BasicQueueElement & o) const {
         return !operator==(o);
     }
-    bool operator<(const QueueElement & o) const {
+    bool operator<(const BasicQueueElement & o) const {
         return get_dist() > o.get_dist();
     }
-    bool operator>(const QueueElement & o) const {
+    bool operator>(const BasicQueueElement & o) const {
         return get_dist() < o.get_dist();
     }
-    bool operator<=(const QueueElement & o) const {
+    bool operator<=(const BasicQueueElement & o) const {
         return get_dist() >= o.get_dist();
     }
-    bool operator>=(const QueueElement & o) const {
+    bool operator>=(const BasicQueueElement & o) const {
         return get_dist() <= o.get_dist();
     }
 };
 
 static const DistType empty_element_dist = -1;
-static const QueueElement empty_element(0, empty_element_dist);
 
-template<int d = 8>
+// One instance per layout for the whole program, so that comparing pointers against it works across translation units.
+template<class Layout, class Dist>
+const BasicQueueElement<Layout, Dist> BasicQueueElement<Layout, Dist>::empty_element(0, (Dist)empty_element_dist);
+
+using QueueElement = BasicQueueElement<>;
+
+static const QueueElement & empty_element = QueueElement::empty_element;
+
+template<int d = 8, class Element = QueueElement>
 class my_d_ary_heap {
+public:
+    using element_type = Element;
 private:
     size_t size = 0;
-    std::vector<QueueElement *> elements;
+    std::vector<Element *> elements;
     Spinlock spinlock;
-    std::atomic<QueueElement *> top_element{const_cast<QueueElement *>(&empty_element)};
+    std::atomic<Element *> top_element{const_cast<Element *>(&Element::empty_element)};
 
     void swap(size_t i, size_t j) {
         std::swap(elements[i], elements[j]);
@@ -111,7 +177,7 @@ private:
     }
     void sift_down(size_t i) {
         if (size == 0) {
-            top_element.store(const_cast<QueueElement *>(&empty_element), std::memory_order_relaxed);
+            top_element.store(const_cast<Element *>(&Element::empty_element), std::memory_order_relaxed);
             return;
         }
         while (has_at_least_one_child(i)) {
@@ -122,7 +188,7 @@ private:
         }
         top_element.store(elements[0], std::memory_order_relaxed);
     }
-    void set(size_t i, QueueElement * element) {
+    void set(size_t i, Element * element) {
         elements[i] = element;
         elements[i]->index = i;
     }
@@ -154,10 +220,22 @@ public:
     bool empty() const {
         return size == 0;
     }
-    QueueElement * top() const {
-        return empty() ? const_cast<QueueElement *>(&empty_element) : elements.front();
+    bool full() const {
+        return size == elements.size();
     }
-    QueueElement * top_relaxed() const {
+    std::size_t capacity() const {
+        return elements.size();
+    }
+    // Only under the lock, if other threads use the heap.
+    void reserve(std::size_t reserve_size) {
+        if (reserve_size > elements.size()) {
+            elements.resize(reserve_size);
+        }
+    }
+    Element * top() const {
+        return empty() ? const_cast<Element *>(&Element::empty_element) : elements.front();
+    }
+    Element * top_relaxed() const {
         return top_element.load(std::memory_order_relaxed);
     }
     void pop() {
@@ -166,7 +244,7 @@ public:
         set(0, elements[size]);
         sift_down(0);
     }
-    void push(QueueElement * element) {
+    void push(Element * element) {
         size++;
         if (size > elements.size()) {
             throw std::logic_error("my_d_ary_heap reserve size is exceeded");
@@ -174,7 +252,11 @@ public:
         set(size - 1, element);
         sift_up(size - 1);
     }
-    void decrease_key(QueueElement * element, int new_dist) {
+    void clear() {
+        size = 0;
+        top_element.store(const_cast<Element *>(&Element::empty_element), std::memory_order_relaxed);
+    }
+    void decrease_key(Element * element, typename Element::dist_type new_dist) {
         if (new_dist < element->get_dist()) { // redundant if?
             element->set_dist_relaxed(new_dist);
             size_t i = element->index;
@@ -184,6 +266,9 @@ public:
     void lock() {
         spinlock.lock();
     }
+    bool try_lock() {
+        return spinlock.try_lock();
+    }
     void unlock() {
         spinlock.unlock();
     }
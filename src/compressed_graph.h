@@ -0,0 +1,229 @@
+#ifndef MULTIQUEUE_COMPRESSED_GRAPH_H
+#define MULTIQUEUE_COMPRESSED_GRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dijkstra.h"
+#include "utils.h"
+
+// An adjacency list in a byte stream, a drop-in replacement for AdjList in the Dijkstra routines.
+//
+// The arcs of each vertex are sorted by target and stored as pairs of byte-aligned varints (7 bits per byte, the high
+// bit marks that more bytes follow): the target as a delta from the previous target (from the vertex itself for the
+// first arc, zigzag-encoded as it may be negative), then the weight. On road graphs most deltas and weights take one
+// or two bytes, so an arc takes 3-5 bytes instead of 16 in Edge. Deltas are zigzag-encoded into 32 bits, and a delta
+// spans +-(n - 1), so graphs have up to 2^31 vertices.
+//
+// graph[v] is a range of Edge values decoded on the fly, so `for (Edge e : graph[v])` works for both formats.
+
+class CompressedGraph {
+private:
+    std::vector<uint64_t> offsets;
+    std::vector<uint8_t> bytes;
+    std::size_t num_arcs = 0;
+
+    static uint32_t zigzag(int64_t delta) {
+        return (uint32_t)(((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    }
+    static int64_t unzigzag(uint32_t value) {
+        return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+    }
+    static std::size_t varint_size(uint32_t value) {
+        std::size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+    static uint8_t * write_varint(uint8_t * out, uint32_t value) {
+        while (value >= 0x80) {
+            *out++ = (uint8_t)(value | 0x80);
+            value >>= 7;
+        }
+        *out++ = (uint8_t)value;
+        return out;
+    }
+    static void sort_edges(std::vector<Edge> & edges) {
+        std::sort(edges.begin(), edges.end(), [](const Edge & a, const Edge & b) {
+            return a.get_to() < b.get_to();
+        });
+    }
+
+public:
+    // The zigzag code of a delta of +-(max_vertexes - 1) fits in 32 bits.
+    static constexpr std::size_t max_vertexes = (std::size_t)1 << 31;
+
+    // One byte for small values, which are the common case, without a loop.
+    static uint32_t read_varint(const uint8_t *& in) {
+        uint32_t value = *in++;
+        if (value < 0x80) {
+            return value;
+        }
+        value &= 0x7F;
+        for (int shift = 7; ; shift += 7) {
+            uint32_t byte = *in++;
+            value |= (byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                return value;
+            }
+        }
+    }
+
+    class EdgeIterator {
+    private:
+        const uint8_t * position;
+        const uint8_t * next;
+        const uint8_t * end;
+        Vertex previous;
+        Edge edge{0, 0};
+        void decode() {
+            if (position == end) {
+                return;
+            }
+            next = position;
+            Vertex to = (Vertex)((int64_t)previous + unzigzag(read_varint(next)));
+            edge = Edge(to, (DistType)read_varint(next));
+            previous = to;
+        }
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Edge;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Edge *;
+        using reference = const Edge &;
+        EdgeIterator(const uint8_t * position, const uint8_t * end, Vertex from)
+                : position(position), next(position), end(end), previous(from) {
+            decode();
+        }
+        const Edge & operator*() const {
+            return edge;
+        }
+        const Edge * operator->() const {
+            return &edge;
+        }
+        EdgeIterator & operator++() {
+            position = next;
+            decode();
+            return *this;
+        }
+        bool operator==(const EdgeIterator & o) const {
+            return position == o.position;
+        }
+        bool operator!=(const EdgeIterator & o) const {
+            return position != o.position;
+        }
+    };
+
+    class EdgeRange {
+    private:
+        const uint8_t * first;
+        const uint8_t * last;
+        Vertex from;
+    public:
+        EdgeRange(const uint8_t * first, const uint8_t * last, Vertex from) : first(first), last(last), from(from) {}
+        EdgeIterator begin() const {
+            return EdgeIterator(first, last, from);
+        }
+        EdgeIterator end() const {
+            return EdgeIterator(last, last, from);
+        }
+        bool empty() const {
+            return first == last;
+        }
+    };
+
+    CompressedGraph() : offsets(1, 0) {}
+
+    // Encodes the vertices in parallel. Throws std::invalid_argument on more than max_vertexes vertices.
+    explicit CompressedGraph(const AdjList & graph, std::size_t num_threads = std::thread::hardware_concurrency())
+            : offsets(graph.size() + 1, 0) {
+        if (graph.size() > max_vertexes) {
+            throw std::invalid_argument("too many vertices for 32-bit deltas: " + std::to_string(graph.size()));
+        }
+        num_threads = std::max<std::size_t>(num_threads, 1);
+        std::vector<std::vector<Edge>> buffers(num_threads);
+        parallel_for(graph.size(), num_threads,
+                [this, &graph, &buffers](std::size_t thread_id, std::size_t begin, std::size_t end) {
+            std::vector<Edge> & edges = buffers[thread_id];
+            for (Vertex v = begin; v < end; v++) {
+                edges.assign(graph[v].begin(), graph[v].end());
+                sort_edges(edges);
+                uint64_t size = 0;
+                Vertex previous = v;
+                for (const Edge & edge : edges) {
+                    size += varint_size(zigzag((int64_t)edge.get_to() - (int64_t)previous));
+                    size += varint_size((uint32_t)edge.get_weight());
+                    previous = edge.get_to();
+                }
+                offsets[v + 1] = size;
+            }
+        });
+        for (std::size_t v = 0; v < graph.size(); v++) {
+            offsets[v + 1] += offsets[v];
+            num_arcs += graph[v].size();
+        }
+        bytes.resize(offsets.back());
+        parallel_for(graph.size(), num_threads,
+                [this, &graph, &buffers](std::size_t thread_id, std::size_t begin, std::size_t end) {
+            std::vector<Edge> & edges = buffers[thread_id];
+            for (Vertex v = begin; v < end; v++) {
+                edges.assign(graph[v].begin(), graph[v].end());
+                sort_edges(edges);
+                uint8_t * out = bytes.data() + offsets[v];
+                Vertex previous = v;
+                for (const Edge & edge : edges) {
+                    out = write_varint(out, zigzag((int64_t)edge.get_to() - (int64_t)previous));
+                    out = write_varint(out, (uint32_t)edge.get_weight());
+                    previous = edge.get_to();
+                }
+            }
+        });
+    }
+
+    EdgeRange operator[](Vertex v) const {
+        return EdgeRange(bytes.data() + offsets[v], bytes.data() + offsets[v + 1], v);
+    }
+    std::size_t size() const {
+        return offsets.size() - 1;
+    }
+    std::size_t get_num_arcs() const {
+        return num_arcs;
+    }
+    void prefetch_index(Vertex v) const {
+        __builtin_prefetch(&offsets[v]);
+    }
+    void prefetch_arcs(Vertex v) const {
+        __builtin_prefetch(bytes.data() + offsets[v]);
+    }
+    // Memory taken by the arcs and the offsets.
+    std::size_t get_num_bytes() const {
+        return bytes.size() + offsets.size() * sizeof(uint64_t);
+    }
+
+    // The arcs of each vertex come back sorted by target.
+    AdjList decompress() const {
+        AdjList graph(size());
+        for (Vertex v = 0; v < size(); v++) {
+            for (const Edge & edge : (*this)[v]) {
+                graph[v].push_back(edge);
+            }
+        }
+        return graph;
+    }
+};
+
+inline void prefetch_arcs_index(const CompressedGraph & graph, Vertex v) {
+    graph.prefetch_index(v);
+}
+inline void prefetch_arcs(const CompressedGraph & graph, Vertex v) {
+    graph.prefetch_arcs(v);
+}
+
+#endif //MULTIQUEUE_COMPRESSED_GRAPH_H
@@ -0,0 +1,673 @@
+#ifndef MULTIQUEUE_CONTRACTION_HIERARCHIES_H
+#define MULTIQUEUE_CONTRACTION_HIERARCHIES_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <boost/thread/barrier.hpp>
+
+#include "binary_heap.h"
+#include "dijkstra.h"
+#include "search_space.h"
+#include "utils.h"
+
+// Contraction Hierarchies (Geisberger, Sanders, Schultes, Delling, 2008).
+//
+// Vertices are contracted in rounds. Each round contracts an independent set of vertices whose priority (edge
+// difference plus the number of contracted neighbours) is a local minimum, in parallel. Contracting a vertex v adds
+// a shortcut u -> w for each pair of arcs u -> v -> w unless a witness search finds a path from u to w which is not
+// longer and avoids v. The round of a vertex is its level: all neighbours of a vertex at the time of its contraction
+// get higher levels.
+//
+// A point-to-point query runs Dijkstra upwards (to higher levels) from both ends. A one-to-all query (PHAST, Delling
+// et al., 2011) runs Dijkstra upwards from the start vertex and then sweeps the levels downwards, relaxing the
+// arcs coming from higher levels; the vertices of one level are independent and are swept in parallel.
+//
+// Contraction stops when the remaining graph gets dense, as on random graphs, and the remaining vertices form the core:
+// the top level, whose arcs to each other are all kept as upward arcs. Queries search the core completely.
+
+class CHArc {
+public:
+    CHArc(CompactVertex to, DistType weight) : to(to), weight(weight) {}
+    CompactVertex to;
+    DistType weight;
+};
+
+class CHParams {
+public:
+    // Witness searches stop after settling that many vertices, fewer mean more shortcuts but faster contraction.
+    std::size_t priority_max_settled = 30;
+    std::size_t contraction_max_settled = 500;
+    // The remaining vertices become the core once they have more arcs per vertex.
+    double core_degree = 16;
+};
+
+class ContractionHierarchy;
+
+// Upward searches on road graphs touch a few hundred vertices, the search spaces of a query grow from that many.
+const std::size_t ch_query_initial_touched = 1024;
+
+class CHQuery {
+private:
+    const ContractionHierarchy & ch;
+    SearchSpace forward;
+    SearchSpace backward;
+public:
+    explicit CHQuery(const ContractionHierarchy & ch);
+    DistType distance(Vertex from, Vertex to);
+};
+
+class ContractionHierarchy {
+private:
+    friend class CHQuery;
+    static constexpr char file_magic[8] = {'M', 'Q', 'C', 'H', '2', '\0', '\0', '\0'};
+
+    std::size_t num_vertexes = 0;
+    std::size_t num_input_arcs = 0;
+    uint64_t input_checksum = 0;
+    std::size_t num_levels = 0;
+    bool has_core = false;
+    std::vector<CompactVertex> levels;
+    // Arcs from each vertex to higher levels, and arcs to each vertex from higher levels.
+    std::vector<std::size_t> up_out_begin;
+    std::vector<CHArc> up_out;
+    std::vector<std::size_t> up_in_begin;
+    std::vector<CHArc> up_in;
+    // The PHAST sweep order: vertices by descending level. sweep_in are up_in in sweep positions.
+    std::vector<CompactVertex> sweep_position;
+    std::vector<std::size_t> level_begin;
+    std::vector<std::size_t> sweep_in_begin;
+    std::vector<CHArc> sweep_in;
+
+    class Shortcut {
+    public:
+        CompactVertex from;
+        CompactVertex to;
+        DistType weight;
+    };
+
+    class Builder;
+
+    static void to_csr(std::vector<std::vector<CHArc>> & lists, std::vector<std::size_t> & begin,
+                       std::vector<CHArc> & arcs) {
+        begin.assign(lists.size() + 1, 0);
+        for (std::size_t v = 0; v < lists.size(); v++) {
+            begin[v + 1] = begin[v] + lists[v].size();
+        }
+        arcs.clear();
+        arcs.reserve(begin.back());
+        for (auto & list : lists) {
+            arcs.insert(arcs.end(), list.begin(), list.end());
+            std::vector<CHArc>().swap(list);
+        }
+    }
+
+    void build_sweep() {
+        std::vector<std::size_t> level_sizes(num_levels + 1, 0);
+        for (CompactVertex level : levels) {
+            level_sizes[level]++;
+        }
+        // Level num_levels - 1 comes first.
+        level_begin.assign(num_levels + 1, 0);
+        for (std::size_t i = 0; i < num_levels; i++) {
+            level_begin[i + 1] = level_begin[i] + level_sizes[num_levels - 1 - i];
+        }
+        std::vector<std::size_t> next(level_begin.begin(), level_begin.end() - 1);
+        sweep_position.resize(num_vertexes);
+        std::vector<CompactVertex> vertex_at(num_vertexes);
+        for (Vertex v = 0; v < num_vertexes; v++) {
+            std::size_t position = next[num_levels - 1 - levels[v]]++;
+            sweep_position[v] = (CompactVertex)position;
+            vertex_at[position] = (CompactVertex)v;
+        }
+        sweep_in_begin.assign(num_vertexes + 1, 0);
+        sweep_in.clear();
+        sweep_in.reserve(up_in.size());
+        for (std::size_t position = 0; position < num_vertexes; position++) {
+            Vertex v = vertex_at[position];
+            for (std::size_t i = up_in_begin[v]; i < up_in_begin[v + 1]; i++) {
+                sweep_in.emplace_back(sweep_position[up_in[i].to], up_in[i].weight);
+            }
+            sweep_in_begin[position + 1] = sweep_in.size();
+        }
+    }
+
+    template<class T>
+    static void write_vector(std::ofstream & output, const std::vector<T> & v) {
+        auto size = (uint64_t)v.size();
+        output.write(reinterpret_cast<const char *>(&size), sizeof(size));
+        output.write(reinterpret_cast<const char *>(v.data()), (std::streamsize)(v.size() * sizeof(T)));
+    }
+
+    template<class T>
+    static bool read_vector(std::ifstream & input, std::vector<T> & v, uint64_t max_size) {
+        uint64_t size = 0;
+        input.read(reinterpret_cast<char *>(&size), sizeof(size));
+        if (!input.good() || size > max_size) {
+            return false;
+        }
+        v.resize(size, T(0, 0));
+        input.read(reinterpret_cast<char *>(v.data()), (std::streamsize)(size * sizeof(T)));
+        return input.good();
+    }
+
+    // FNV-1a over the head and the weight of every arc, with the degree of each vertex, so that a graph with new
+    // weights but the same shape doesn't match a saved hierarchy.
+    static uint64_t checksum(const AdjList & graph) {
+        uint64_t hash = 14695981039346656037ULL;
+        auto add = [&hash](uint64_t value) {
+            for (int i = 0; i < 8; i++) {
+                hash = (hash ^ (value & 0xff)) * 1099511628211ULL;
+                value >>= 8;
+            }
+        };
+        for (const auto & edges : graph) {
+            add(edges.size());
+            for (const Edge & edge : edges) {
+                add(edge.get_to());
+                add((uint64_t)(int64_t)edge.get_weight());
+            }
+        }
+        return hash;
+    }
+
+public:
+    static ContractionHierarchy build(const AdjList & graph,
+                                      std::size_t num_threads = std::thread::hardware_concurrency(),
+                                      const CHParams & params = CHParams());
+
+    std::size_t get_num_vertexes() const {
+        return num_vertexes;
+    }
+    std::size_t get_num_levels() const {
+        return num_levels;
+    }
+    std::size_t get_core_size() const {
+        return has_core ? level_begin[1] : 0;
+    }
+    std::size_t get_num_arcs() const {
+        return up_out.size() + up_in.size();
+    }
+    // A contraction hierarchy matches a graph with the same numbers of vertices and arcs and the same arcs checksum.
+    bool matches(const AdjList & graph) const {
+        std::size_t num_arcs = 0;
+        for (const auto & edges : graph) {
+            num_arcs += edges.size();
+        }
+        return graph.size() == num_vertexes && num_arcs == num_input_arcs && checksum(graph) == input_checksum;
+    }
+
+    // Point-to-point distances for pairs of vertices, queried in parallel.
+    DistVector distances(const std::vector<std::pair<Vertex, Vertex>> & pairs,
+                         std::size_t num_threads = std::thread::hardware_concurrency()) const {
+        DistVector dists(pairs.size());
+        std::vector<std::unique_ptr<CHQuery>> queries(num_threads);
+        parallel_for(pairs.size(), num_threads,
+                [this, &pairs, &dists, &queries](std::size_t thread_id, std::size_t begin, std::size_t end) {
+            if (!queries[thread_id]) {
+                queries[thread_id].reset(new CHQuery(*this));
+            }
+            for (std::size_t i = begin; i < end; i++) {
+                dists[i] = queries[thread_id]->distance(pairs[i].first, pairs[i].second);
+            }
+        }, 64);
+        return dists;
+    }
+
+    // Distances from start_vertex to all vertices (PHAST).
+    DistVector distances_from(Vertex start_vertex, std::size_t num_threads, Timer & state) const {
+        const DistType infinity = std::numeric_limits<DistType>::max();
+        DistVector sweep_dists(num_vertexes, infinity);
+        if (num_vertexes == 0) {
+            return sweep_dists;
+        }
+        state.resume_timing();
+        using QueueItem = std::pair<DistType, CompactVertex>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> q;
+        sweep_dists[sweep_position[start_vertex]] = 0;
+        q.emplace(0, (CompactVertex)start_vertex);
+        while (!q.empty()) {
+            DistType dist = q.top().first;
+            Vertex v = q.top().second;
+            q.pop();
+            if (dist > sweep_dists[sweep_position[v]]) {
+                continue;
+            }
+            for (std::size_t i = up_out_begin[v]; i < up_out_begin[v + 1]; i++) {
+                DistType new_dist = dist + up_out[i].weight;
+                DistType & old_dist = sweep_dists[sweep_position[up_out[i].to]];
+                if (new_dist < old_dist) {
+                    old_dist = new_dist;
+                    q.emplace(new_dist, up_out[i].to);
+                }
+            }
+        }
+
+        boost::barrier barrier(num_threads);
+        auto sweep_routine = [this, &sweep_dists, &barrier, num_threads, infinity](std::size_t thread_id) {
+            // Distances in the core are final after the upward search.
+            for (std::size_t level = has_core ? 1 : 0; level < num_levels; level++) {
+                std::size_t level_size = level_begin[level + 1] - level_begin[level];
+                std::size_t begin = level_begin[level] + level_size * thread_id / num_threads;
+                std::size_t end = level_begin[level] + level_size * (thread_id + 1) / num_threads;
+                for (std::size_t position = begin; position < end; position++) {
+                    DistType dist = sweep_dists[position];
+                    for (std::size_t i = sweep_in_begin[position]; i < sweep_in_begin[position + 1]; i++) {
+                        DistType from_dist = sweep_dists[sweep_in[i].to];
+                        if (from_dist != infinity && from_dist + sweep_in[i].weight < dist) {
+                            dist = from_dist + sweep_in[i].weight;
+                        }
+                    }
+                    sweep_dists[position] = dist;
+                }
+                barrier.wait();
+            }
+        };
+        std::vector<std::thread> threads;
+        for (std::size_t thread_id = 1; thread_id < num_threads; thread_id++) {
+            threads.emplace_back(sweep_routine, thread_id);
+            pin_thread(thread_id, threads.back());
+        }
+        sweep_routine(0);
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+        state.pause_timing();
+
+        DistVector dists(num_vertexes);
+        for (Vertex v = 0; v < num_vertexes; v++) {
+            dists[v] = sweep_dists[sweep_position[v]];
+        }
+        return dists;
+    }
+
+    bool save(const std::string & filename) const {
+        std::ofstream output(filename, std::ios::binary);
+        const uint64_t header[] = {num_vertexes, num_input_arcs, num_levels, has_core, input_checksum};
+        output.write(file_magic, sizeof(file_magic));
+        output.write(reinterpret_cast<const char *>(header), sizeof(header));
+        output.write(reinterpret_cast<const char *>(levels.data()),
+                     (std::streamsize)(levels.size() * sizeof(CompactVertex)));
+        output.write(reinterpret_cast<const char *>(up_out_begin.data()),
+                     (std::streamsize)(up_out_begin.size() * sizeof(std::size_t)));
+        write_vector(output, up_out);
+        output.write(reinterpret_cast<const char *>(up_in_begin.data()),
+                     (std::streamsize)(up_in_begin.size() * sizeof(std::size_t)));
+        write_vector(output, up_in);
+        return output.good();
+    }
+
+    // Returns false if the file doesn't exist or isn't a contraction hierarchy.
+    bool load(const std::string & filename) {
+        std::ifstream input(filename, std::ios::binary);
+        char magic[sizeof(file_magic)];
+        uint64_t header[5];
+        input.read(magic, sizeof(magic));
+        input.read(reinterpret_cast<char *>(header), sizeof(header));
+        if (!input.good() || std::memcmp(magic, file_magic, sizeof(magic)) != 0 || header[2] > header[0]) {
+            return false;
+        }
+        num_vertexes = header[0];
+        num_input_arcs = header[1];
+        num_levels = header[2];
+        has_core = header[3] != 0;
+        input_checksum = header[4];
+        levels.resize(num_vertexes);
+        up_out_begin.resize(num_vertexes + 1);
+        up_in_begin.resize(num_vertexes + 1);
+        input.read(reinterpret_cast<char *>(levels.data()), (std::streamsize)(num_vertexes * sizeof(CompactVertex)));
+        input.read(reinterpret_cast<char *>(up_out_begin.data()),
+                   (std::streamsize)((num_vertexes + 1) * sizeof(std::size_t)));
+        const uint64_t max_arcs = std::numeric_limits<uint32_t>::max() * (uint64_t)16;
+        if (!input.good() || !read_vector(input, up_out, max_arcs)) {
+            return false;
+        }
+        input.read(reinterpret_cast<char *>(up_in_begin.data()),
+                   (std::streamsize)((num_vertexes + 1) * sizeof(std::size_t)));
+        if (!input.good() || !read_vector(input, up_in, max_arcs)) {
+            return false;
+        }
+        for (CompactVertex level : levels) {
+            if (level >= num_levels) {
+                return false;
+            }
+        }
+        if (up_out_begin.back() != up_out.size() || up_in_begin.back() != up_in.size()) {
+            return false;
+        }
+        build_sweep();
+        return true;
+    }
+};
+
+class ContractionHierarchy::Builder {
+private:
+    const std::size_t num_vertexes;
+    const std::size_t num_threads;
+    const CHParams params;
+    // The remaining graph, arcs to and from contracted vertices are removed.
+    std::vector<std::vector<CHArc>> out;
+    std::vector<std::vector<CHArc>> in;
+    std::unique_ptr<Spinlock[]> locks;
+    std::vector<int64_t> priorities;
+    std::vector<CompactVertex> contracted_neighbours;
+    std::vector<char> dirty;
+    std::vector<char> selected;
+    std::vector<std::unique_ptr<SearchSpace>> search_spaces;
+    std::vector<std::vector<Shortcut>> thread_shortcuts;
+    std::vector<std::vector<CompactVertex>> thread_targets;
+
+    static uint64_t tie_breaker(Vertex v) {
+        uint64_t seed = v;
+        return random_fnv1a(seed);
+    }
+
+    bool is_less(Vertex u, Vertex v) const {
+        if (priorities[u] != priorities[v]) {
+            return priorities[u] < priorities[v];
+        }
+        uint64_t hu = tie_breaker(u);
+        uint64_t hv = tie_breaker(v);
+        return hu != hv ? hu < hv : u < v;
+    }
+
+    SearchSpace & get_search_space(std::size_t thread_id) {
+        if (!search_spaces[thread_id]) {
+            search_spaces[thread_id].reset(new SearchSpace(num_vertexes, params.contraction_max_settled * 16));
+        }
+        return *search_spaces[thread_id];
+    }
+
+    // Appends to shortcuts the shortcuts needed to contract v. Witness paths avoid v and the selected vertices.
+    void find_shortcuts(Vertex v, std::size_t thread_id, std::size_t max_settled, std::vector<Shortcut> & shortcuts) {
+        SearchSpace & space = get_search_space(thread_id);
+        // The distinct targets, each settled once, so each is counted once.
+        std::vector<CompactVertex> & targets = thread_targets[thread_id];
+        targets.clear();
+        for (const CHArc & out_arc : out[v]) {
+            targets.push_back(out_arc.to);
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        for (const CHArc & in_arc : in[v]) {
+            Vertex from = in_arc.to;
+            DistType bound = -1;
+            for (const CHArc & out_arc : out[v]) {
+                if (out_arc.to != from) {
+                    bound = std::max(bound, in_arc.weight + out_arc.weight);
+                }
+            }
+            if (bound < 0) {
+                continue;
+            }
+            // from isn't a target, though it's popped first.
+            std::size_t num_targets = targets.size()
+                    - (std::binary_search(targets.begin(), targets.end(), (CompactVertex)from) ? 1 : 0);
+            space.clear();
+            space.relax(from, 0);
+            std::size_t num_settled = 0;
+            while (!space.empty() && space.get_min_dist() <= bound && num_settled < max_settled && num_targets > 0) {
+                SearchSpace::Element * element = space.pop();
+                num_settled++;
+                DistType dist = element->get_dist_relaxed();
+                if (element->vertex != from
+                        && std::binary_search(targets.begin(), targets.end(), (CompactVertex)element->vertex)) {
+                    num_targets--;
+                }
+                for (const CHArc & arc : out[element->vertex]) {
+                    if (arc.to != v && !selected[arc.to]) {
+                        space.relax(arc.to, dist + arc.weight);
+                    }
+                }
+            }
+            for (const CHArc & out_arc : out[v]) {
+                DistType via_dist = in_arc.weight + out_arc.weight;
+                if (out_arc.to != from && space.get_dist(out_arc.to) > via_dist) {
+                    shortcuts.push_back({(CompactVertex)from, out_arc.to, via_dist});
+                }
+            }
+        }
+    }
+
+    static void remove_arc(std::vector<CHArc> & arcs, Vertex to) {
+        for (std::size_t i = 0; i < arcs.size(); i++) {
+            if (arcs[i].to == to) {
+                arcs[i] = arcs.back();
+                arcs.pop_back();
+                return;
+            }
+        }
+    }
+
+    static void add_arc(std::vector<CHArc> & arcs, CompactVertex to, DistType weight) {
+        for (CHArc & arc : arcs) {
+            if (arc.to == to) {
+                arc.weight = std::min(arc.weight, weight);
+                return;
+            }
+        }
+        arcs.emplace_back(to, weight);
+    }
+
+public:
+    Builder(const AdjList & graph, std::size_t num_threads, const CHParams & params)
+            : num_vertexes(graph.size()), num_threads(std::max<std::size_t>(1, num_threads)), params(params),
+              out(num_vertexes), in(num_vertexes), locks(new Spinlock[num_vertexes]),
+              priorities(num_vertexes, 0), contracted_neighbours(num_vertexes, 0), dirty(num_vertexes, true),
+              selected(num_vertexes, false), search_spaces(this->num_threads), thread_shortcuts(this->num_threads),
+              thread_targets(this->num_threads) {
+        // Parallel arcs are merged and loops are dropped.
+        for (Vertex from = 0; from < num_vertexes; from++) {
+            for (const Edge & edge : graph[from]) {
+                if (edge.get_to() != from) {
+                    add_arc(out[from], (CompactVertex)edge.get_to(), edge.get_weight());
+                }
+            }
+        }
+        for (Vertex from = 0; from < num_vertexes; from++) {
+            for (const CHArc & arc : out[from]) {
+                in[arc.to].emplace_back((CompactVertex)from, arc.weight);
+            }
+        }
+    }
+
+    void build(ContractionHierarchy & ch) {
+        ch.num_vertexes = num_vertexes;
+        ch.levels.assign(num_vertexes, 0);
+        std::vector<std::vector<CHArc>> up_out_lists(num_vertexes);
+        std::vector<std::vector<CHArc>> up_in_lists(num_vertexes);
+        std::vector<CompactVertex> remaining(num_vertexes);
+        for (Vertex v = 0; v < num_vertexes; v++) {
+            remaining[v] = (CompactVertex)v;
+        }
+        std::vector<CompactVertex> independent_set;
+        std::mutex independent_set_mutex;
+
+        for (CompactVertex level = 0; !remaining.empty(); level++) {
+            std::size_t num_remaining_arcs = 0;
+            for (CompactVertex v : remaining) {
+                num_remaining_arcs += out[v].size();
+            }
+            if (num_remaining_arcs > params.core_degree * (double)remaining.size()) {
+                for (CompactVertex v : remaining) {
+                    ch.levels[v] = level;
+                    up_out_lists[v] = std::move(out[v]);
+                    up_in_lists[v] = std::move(in[v]);
+                }
+                ch.has_core = true;
+                ch.num_levels = level + 1;
+                break;
+            }
+            parallel_for(remaining.size(), num_threads,
+                    [this, &remaining](std::size_t thread_id, std::size_t begin, std::size_t end) {
+                std::vector<Shortcut> & shortcuts = thread_shortcuts[thread_id];
+                for (std::size_t i = begin; i < end; i++) {
+                    Vertex v = remaining[i];
+                    if (!dirty[v]) {
+                        continue;
+                    }
+                    shortcuts.clear();
+                    find_shortcuts(v, thread_id, params.priority_max_settled, shortcuts);
+                    auto edge_difference = (int64_t)shortcuts.size() - (int64_t)(in[v].size() + out[v].size());
+                    priorities[v] = edge_difference + contracted_neighbours[v];
+                    dirty[v] = false;
+                }
+            }, 256);
+
+            independent_set.clear();
+            parallel_for(remaining.size(), num_threads,
+                    [this, &remaining, &independent_set, &independent_set_mutex]
+                    (std::size_t, std::size_t begin, std::size_t end) {
+                std::vector<CompactVertex> local_set;
+                for (std::size_t i = begin; i < end; i++) {
+                    Vertex v = remaining[i];
+                    bool is_local_minimum = true;
+                    for (const auto * arcs : {&out[v], &in[v]}) {
+                        for (const CHArc & arc : *arcs) {
+                            if (!is_less(v, arc.to)) {
+                                is_local_minimum = false;
+                                break;
+                            }
+                        }
+                    }
+                    if (is_local_minimum) {
+                        local_set.push_back((CompactVertex)v);
+                    }
+                }
+                std::lock_guard<std::mutex> lock(independent_set_mutex);
+                independent_set.insert(independent_set.end(), local_set.begin(), local_set.end());
+            });
+            for (CompactVertex v : independent_set) {
+                selected[v] = true;
+            }
+
+            for (auto & shortcuts : thread_shortcuts) {
+                shortcuts.clear();
+            }
+            parallel_for(independent_set.size(), num_threads,
+                    [this, &independent_set](std::size_t thread_id, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++) {
+                    find_shortcuts(independent_set[i], thread_id, params.contraction_max_settled,
+                                   thread_shortcuts[thread_id]);
+                }
+            }, 16);
+
+            // Neighbours of a contracted vertex aren't contracted in the same round, so its arcs only change here.
+            parallel_for(independent_set.size(), num_threads,
+                    [this, &independent_set, &up_out_lists, &up_in_lists, &ch, level]
+                    (std::size_t, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; i++) {
+                    Vertex v = independent_set[i];
+                    ch.levels[v] = level;
+                    for (const CHArc & arc : out[v]) {
+                        locks[arc.to].lock();
+                        remove_arc(in[arc.to], v);
+                        contracted_neighbours[arc.to]++;
+                        dirty[arc.to] = true;
+                        locks[arc.to].unlock();
+                    }
+                    for (const CHArc & arc : in[v]) {
+                        locks[arc.to].lock();
+                        remove_arc(out[arc.to], v);
+                        contracted_neighbours[arc.to]++;
+                        dirty[arc.to] = true;
+                        locks[arc.to].unlock();
+                    }
+                    up_out_lists[v] = std::move(out[v]);
+                    up_in_lists[v] = std::move(in[v]);
+                    std::vector<CHArc>().swap(out[v]);
+                    std::vector<CHArc>().swap(in[v]);
+                }
+            }, 64);
+            for (const auto & shortcuts : thread_shortcuts) {
+                parallel_for(shortcuts.size(), num_threads,
+                        [this, &shortcuts](std::size_t, std::size_t begin, std::size_t end) {
+                    for (std::size_t i = begin; i < end; i++) {
+                        const Shortcut & shortcut = shortcuts[i];
+                        locks[shortcut.from].lock();
+                        add_arc(out[shortcut.from], shortcut.to, shortcut.weight);
+                        locks[shortcut.from].unlock();
+                        locks[shortcut.to].lock();
+                        add_arc(in[shortcut.to], shortcut.from, shortcut.weight);
+                        locks[shortcut.to].unlock();
+                    }
+                }, 1024);
+            }
+
+            for (CompactVertex v : independent_set) {
+                selected[v] = false;
+            }
+            std::vector<CompactVertex> next_remaining;
+            next_remaining.reserve(remaining.size() - independent_set.size());
+            std::sort(independent_set.begin(), independent_set.end());
+            std::set_difference(remaining.begin(), remaining.end(), independent_set.begin(), independent_set.end(),
+                                std::back_inserter(next_remaining));
+            remaining.swap(next_remaining);
+            ch.num_levels = level + 1;
+        }
+        to_csr(up_out_lists, ch.up_out_begin, ch.up_out);
+        to_csr(up_in_lists, ch.up_in_begin, ch.up_in);
+    }
+};
+
+inline ContractionHierarchy ContractionHierarchy::build(const AdjList & graph, std::size_t num_threads,
+                                                        const CHParams & params) {
+    ContractionHierarchy ch;
+    for (const auto & edges : graph) {
+        ch.num_input_arcs += edges.size();
+    }
+    ch.input_checksum = checksum(graph);
+    Builder(graph, num_threads, params).build(ch);
+    ch.build_sweep();
+    return ch;
+}
+
+inline CHQuery::CHQuery(const ContractionHierarchy & ch)
+        : ch(ch), forward(ch.num_vertexes, ch.num_vertexes, ch_query_initial_touched),
+          backward(ch.num_vertexes, ch.num_vertexes, ch_query_initial_touched) {}
+
+inline DistType CHQuery::distance(Vertex from, Vertex to) {
+    const DistType infinity = std::numeric_limits<DistType>::max();
+    forward.clear();
+    backward.clear();
+    forward.relax(from, 0);
+    backward.relax(to, 0);
+    DistType best = infinity;
+    while (true) {
+        DistType forward_min = forward.empty() ? infinity : forward.get_min_dist();
+        DistType backward_min = backward.empty() ? infinity : backward.get_min_dist();
+        if (std::min(forward_min, backward_min) >= best) {
+            break;
+        }
+        bool is_forward = forward_min <= backward_min;
+        SearchSpace & space = is_forward ? forward : backward;
+        const SearchSpace & other = is_forward ? backward : forward;
+        const auto & begin = is_forward ? ch.up_out_begin : ch.up_in_begin;
+        const auto & arcs = is_forward ? ch.up_out : ch.up_in;
+        SearchSpace::Element * element = space.pop();
+        Vertex v = element->vertex;
+        DistType dist = element->get_dist_relaxed();
+        DistType other_dist = other.get_dist(v);
+        if (other_dist != infinity) {
+            best = std::min(best, dist + other_dist);
+        }
+        for (std::size_t i = begin[v]; i < begin[v + 1]; i++) {
+            space.relax(arcs[i].to, dist + arcs[i].weight);
+        }
+    }
+    return best;
+}
+
+#endif //MULTIQUEUE_CONTRACTION_HIERARCHIES_H
@@ -29,13 +29,15 @@
 #endif
 
 using DistVector = std::vector<DistType>;
+// parents[v] precedes v on a shortest path from the start vertex, or is no_parent for it and unreachable vertices.
+using ParentVector = std::vector<CompactVertex>;
 
 class Timer {
 private:
     benchmark::State * state;
     std::chrono::time_point<std::chrono::high_resolution_clock> start;
     bool running = false;
-    std::chrono::milliseconds total{0};
+    std::chrono::microseconds total{0};
 public:
     explicit Timer(benchmark::State * state = nullptr) :state(state) {}
     void pause_timing() {
@@ -46,7 +48,7 @@ public:
                 return;
             }
             auto end = std::chrono::high_resolution_clock::now();
-            total += std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+            total += std::chrono::duration_cast<std::chrono::microseconds>(end - start);
             running = false;
         }
     }
@@ -62,6 +64,9 @@ public:
         }
     }
     std::chrono::milliseconds get_total() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(total);
+    }
+    std::chrono::microseconds get_total_microseconds() {
         return total;
     }
 };
@@ -81,6 +86,9 @@ public:
     DistType get_weight() const {
         return weight;
     }
+    void set_weight(DistType new_weight) {
+        weight = new_weight;
+    }
 };
 
 using AdjList = std::vector<std::vector<Edge>>;
@@ -88,9 +96,11 @@ using AdjList = std::vector<std::vector<Edge>>;
 class DistsAndStatistics {
 private:
     DistVector dists;
+    ParentVector parents;
     DistVector vertex_pulls_counts;
     std::size_t num_pushes{};
     std::vector<std::size_t> max_queue_sizes;
+    std::size_t num_pops{};
 public:
     DistsAndStatistics(
             DistVector dists, DistVector vertex_pulls_counts, size_t num_pushes,
@@ -98,10 +108,15 @@ public:
             dists(std::move(dists)), vertex_pulls_counts(std::move(vertex_pulls_counts)), num_pushes(num_pushes),
             max_queue_sizes(std::move(max_queue_sizes)) {}
     explicit DistsAndStatistics(DistVector dists) :dists(std::move(dists)) {};
+    DistsAndStatistics(DistVector dists, ParentVector parents) :dists(std::move(dists)), parents(std::move(parents)) {};
     DistsAndStatistics() = default;
     const DistVector &get_dists() const {
         return dists;
     }
+    // Empty unless the parents were requested.
+    const ParentVector &get_parents() const {
+        return parents;
+    }
     const DistVector &get_vertex_pulls_counts() const {
         return vertex_pulls_counts;
     }
@@ -111,38 +126,148 @@ public:
     const std::vector<std::size_t> &get_max_queue_sizes() const {
         return max_queue_sizes;
     }
+    // Vertices popped by the parallel engines, 0 if not counted. Pops beyond the reachable vertices are wasted work.
+    std::size_t get_num_pops() const {
+        return num_pops;
+    }
+    void set_num_pops(std::size_t new_num_pops) {
+        num_pops = new_num_pops;
+    }
+    std::size_t get_num_wasted_pops() const {
+        std::size_t num_reachable = std::count_if(dists.begin(), dists.end(), [](DistType dist) {
+            return dist != DistTraits<DistType>::infinity();
+        });
+        return num_pops > num_reachable ? num_pops - num_reachable : 0;
+    }
 };
 
-inline void dijkstra_thread_routine(const AdjList & graph, Multiqueue & queue,
-                                    std::vector<QueueElement> & vertexes,
-                                    Timer& state, boost::barrier & barrier, std::size_t thread_id) {
+// Lowers the distance of the arc's head through elem, retrying while other threads change it.
+template<class Queue>
+inline void relax_arc(Queue & queue, std::vector<typename Queue::Element> & vertexes,
+                      const typename Queue::Element * elem, const Edge & e) {
+    using Dist = typename Queue::Element::dist_type;
+    Vertex v2 = e.get_to();
+    while (true) {
+        Dist new_v2_dist = DistTraits<Dist>::add(elem->get_dist_relaxed(), (Dist)e.get_weight());
+        Dist old_v2_dist = vertexes[v2].get_dist_relaxed();
+        if (old_v2_dist <= new_v2_dist) {
+            break;
+        }
+        queue.push(&vertexes[v2], new_v2_dist, (CompactVertex)elem->vertex);
+    }
+}
+
+// Prefetches for dijkstra_grouped_thread_routine, overloaded for other graph formats. The index entry of a vertex
+// comes first, as the address of its arcs is read from it.
+inline void prefetch_arcs_index(const AdjList & graph, Vertex v) {
+    __builtin_prefetch(&graph[v]);
+}
+inline void prefetch_arcs(const AdjList & graph, Vertex v) {
+    __builtin_prefetch(graph[v].data());
+}
+
+// Graph is AdjList or another graph whose graph[v] is a range of Edge, such as CompressedGraph.
+// Queue is a Multiqueue or another queue with its interface, such as StealingQueue. Adds the pops to num_pops.
+template<class Queue, class Graph = AdjList>
+void dijkstra_thread_routine(const Graph & graph, Queue & queue,
+                             std::vector<typename Queue::Element> & vertexes,
+                             Timer& state, boost::barrier & barrier, std::size_t thread_id,
+                             std::atomic<std::size_t> * num_pops = nullptr) {
+    using Element = typename Queue::Element;
     barrier.wait();
     if (thread_id == 0) {
         state.resume_timing();
     }
     barrier.wait();
 
+    std::size_t thread_pops = 0;
     while (true) {
-        QueueElement * elem = queue.pop();
+        Element * elem = queue.pop();
         // TODO: fix that most treads might exit if one thread is stuck at cut-vertex
-        if (elem == &empty_element) {
+        if (elem == &Element::empty_element) {
 //            std::cerr << "bye" << std::endl;
             break;
         }
+        thread_pops++;
         const Vertex v = elem->vertex;
         for (Edge e : graph[v]) {
-            Vertex v2 = e.get_to();
-            if (v == v2) continue;
-            while (true) {
-                DistType new_v2_dist = elem->get_dist_relaxed() + e.get_weight();
-                DistType old_v2_dist = vertexes[v2].get_dist_relaxed();
-                if (old_v2_dist <= new_v2_dist) {
-                    break;
+            if (v != e.get_to()) {
+                relax_arc(queue, vertexes, elem, e);
+            }
+        }
+    }
+    if (num_pops != nullptr) {
+        *num_pops += thread_pops;
+    }
+
+    barrier.wait();
+    if (thread_id == 0) {
+        state.pause_timing();
+    }
+    barrier.wait();
+}
+
+// dijkstra_thread_routine which pops group_size vertices at once and interleaves them to hide memory latency. Each
+// step prefetches what the next step reads for all vertices of the group: the index entries of their arcs, then the
+// arcs, then, while the arcs are copied to a buffer, the elements of their heads, which are finally relaxed. On
+// graphs larger than the last level cache, the misses of a group overlap instead of stalling one after another.
+template<class Queue, class Graph = AdjList>
+void dijkstra_grouped_thread_routine(const Graph & graph, Queue & queue,
+                                     std::vector<typename Queue::Element> & vertexes,
+                                     Timer& state, boost::barrier & barrier, std::size_t thread_id,
+                                     std::atomic<std::size_t> * num_pops, std::size_t group_size) {
+    using Element = typename Queue::Element;
+    std::vector<Element *> group;
+    group.reserve(group_size);
+    std::vector<Edge> arcs;
+    arcs.reserve(16 * group_size);
+    std::vector<std::size_t> arcs_ends(group_size);
+    barrier.wait();
+    if (thread_id == 0) {
+        state.resume_timing();
+    }
+    barrier.wait();
+
+    std::size_t thread_pops = 0;
+    while (true) {
+        group.clear();
+        while (group.size() < group_size) {
+            Element * elem = queue.pop();
+            if (elem == &Element::empty_element) {
+                break;
+            }
+            prefetch_arcs_index(graph, elem->vertex);
+            group.push_back(elem);
+        }
+        if (group.empty()) {
+            break;
+        }
+        thread_pops += group.size();
+        for (const Element * elem : group) {
+            prefetch_arcs(graph, elem->vertex);
+        }
+        arcs.clear();
+        for (std::size_t i = 0; i < group.size(); i++) {
+            const Vertex v = group[i]->vertex;
+            for (Edge e : graph[v]) {
+                if (v != e.get_to()) {
+                    __builtin_prefetch(&vertexes[e.get_to()]);
+                    arcs.push_back(e);
                 }
-                queue.push(&vertexes[v2], new_v2_dist);
             }
+            arcs_ends[i] = arcs.size();
+        }
+        std::size_t arcs_begin = 0;
+        for (std::size_t i = 0; i < group.size(); i++) {
+            for (std::size_t k = arcs_begin; k < arcs_ends[i]; k++) {
+                relax_arc(queue, vertexes, group[i], arcs[k]);
+            }
+            arcs_begin = arcs_ends[i];
         }
     }
+    if (num_pops != nullptr) {
+        *num_pops += thread_pops;
+    }
 
     barrier.wait();
     if (thread_id == 0) {
@@ -151,13 +276,16 @@ inline void dijkstra_thread_routine(const AdjList & graph, Multiqueue & queue,
     barrier.wait();
 }
 
-inline DistsAndStatistics calc_dijkstra(const AdjList & graph, std::size_t num_threads,
-                                                  int size_multiple, std::size_t one_queue_reserve_size,
-                                                  Timer& state) {
+// Distances of the queue's distance type, and the parents if parents isn't null. The queue may be prepared by the
+// caller, e.g. a StealingQueue with a lag threshold. Threads pop group_size vertices at once if it's more than 1.
+template<class Queue, class Graph = AdjList>
+std::vector<typename Queue::dist_type> calc_dijkstra_dists(const Graph & graph, Queue & queue, std::size_t num_threads,
+                                                           Timer& state, ParentVector * parents = nullptr,
+                                                           std::size_t * num_pops = nullptr,
+                                                           std::size_t group_size = 1) {
     const Vertex start_vertex = 0;
     std::size_t num_vertexes = graph.size();
-    Multiqueue queue = Multiqueue(num_threads, size_multiple, one_queue_reserve_size);
-    std::vector<QueueElement> vertexes;
+    std::vector<typename Queue::Element> vertexes;
     vertexes.reserve(num_vertexes);
     for (std::size_t i = 0; i < num_vertexes; i++) {
         vertexes.emplace_back(i);
@@ -165,19 +293,81 @@ inline DistsAndStatistics calc_dijkstra(const AdjList & graph, std::size_t num_t
     queue.push_singlethreaded(&vertexes[start_vertex], 0);
     std::vector<std::thread> threads;
     boost::barrier barrier(num_threads);
+    std::atomic<std::size_t> total_pops{0};
     for (std::size_t thread_id = 0; thread_id < num_threads; thread_id++) {
-        threads.emplace_back(dijkstra_thread_routine, std::cref(graph), std::ref(queue), std::ref(vertexes),
-                             std::ref(state), std::ref(barrier), thread_id);
+        if (group_size > 1) {
+            threads.emplace_back(dijkstra_grouped_thread_routine<Queue, Graph>, std::cref(graph), std::ref(queue),
+                                 std::ref(vertexes), std::ref(state), std::ref(barrier), thread_id, &total_pops,
+                                 group_size);
+        } else {
+            threads.emplace_back(dijkstra_thread_routine<Queue, Graph>, std::cref(graph), std::ref(queue),
+                                 std::ref(vertexes), std::ref(state), std::ref(barrier), thread_id, &total_pops);
+        }
         pin_thread(thread_id, threads.back());
     }
     for (std::thread & thread : threads) {
         thread.join();
     }
-    DistVector dists(num_vertexes);
+    std::vector<typename Queue::dist_type> dists(num_vertexes);
     for (std::size_t i = 0; i < num_vertexes; i++) {
         dists[i] = vertexes[i].get_dist();
     }
-    return DistsAndStatistics(dists);
+    if (parents != nullptr) {
+        parents->resize(num_vertexes);
+        for (std::size_t i = 0; i < num_vertexes; i++) {
+            (*parents)[i] = vertexes[i].get_parent_relaxed();
+        }
+    }
+    if (num_pops != nullptr) {
+        *num_pops = total_pops.load();
+    }
+    return dists;
+}
+
+template<class Queue = Multiqueue, class Graph = AdjList>
+std::vector<typename Queue::dist_type> calc_dijkstra_dists(const Graph & graph, std::size_t num_threads,
+                                                           int size_multiple, std::size_t one_queue_reserve_size,
+                                                           Timer& state, ParentVector * parents = nullptr,
+                                                           std::size_t * num_pops = nullptr) {
+    Queue queue(num_threads, size_multiple, one_queue_reserve_size);
+    return calc_dijkstra_dists(graph, queue, num_threads, state, parents, num_pops);
+}
+
+// Distances too large for DistType become infinity, as if unreachable.
+template<class Dist>
+DistVector to_dist_vector(std::vector<Dist> dists) {
+    if constexpr (std::is_same<Dist, DistType>::value) {
+        return dists;
+    }
+    const DistType infinity = DistTraits<DistType>::infinity();
+    DistVector converted(dists.size());
+    for (std::size_t i = 0; i < dists.size(); i++) {
+        converted[i] = dists[i] >= (Dist)infinity ? infinity : (DistType)dists[i];
+    }
+    return converted;
+}
+
+// Parents are recorded along with dists at no extra cost, track_parents only controls returning them.
+template<class Queue, class Graph = AdjList>
+DistsAndStatistics calc_dijkstra(const Graph & graph, Queue & queue, std::size_t num_threads, Timer& state,
+                                 bool track_parents = false, std::size_t group_size = 1) {
+    ParentVector parents;
+    std::size_t num_pops = 0;
+    auto dists = calc_dijkstra_dists(graph, queue, num_threads, state, track_parents ? &parents : nullptr, &num_pops,
+                                     group_size);
+    DistsAndStatistics result = track_parents
+            ? DistsAndStatistics(to_dist_vector(std::move(dists)), std::move(parents))
+            : DistsAndStatistics(to_dist_vector(std::move(dists)));
+    result.set_num_pops(num_pops);
+    return result;
+}
+
+template<class Queue = Multiqueue, class Graph = AdjList>
+DistsAndStatistics calc_dijkstra(const Graph & graph, std::size_t num_threads,
+                                 int size_multiple, std::size_t one_queue_reserve_size,
+                                 Timer& state, bool track_parents = false) {
+    Queue queue(num_threads, size_multiple, one_queue_reserve_size);
+    return calc_dijkstra(graph, queue, num_threads, state, track_parents);
 }
 
 class SimpleQueueElement {
@@ -190,10 +380,11 @@ public:
     }
 };
 
-inline DistsAndStatistics calc_dijkstra_sequential(const AdjList & graph, Timer& state) {
+inline DistsAndStatistics calc_dijkstra_sequential(const AdjList & graph, Timer& state, bool track_parents = false) {
     const Vertex start_vertex = 0;
     std::size_t num_vertexes = graph.size();
-    DistVector dists(num_vertexes, std::numeric_limits<int>::max());
+    DistVector dists(num_vertexes, DistTraits<DistType>::infinity());
+    ParentVector parents(track_parents ? num_vertexes : 0, no_parent);
     std::vector<bool> removed_from_queue(num_vertexes, false);
     std::priority_queue<SimpleQueueElement> q;
     dists[start_vertex] = 0;
@@ -212,15 +403,18 @@ inline DistsAndStatistics calc_dijkstra_sequential(const AdjList & graph, Timer&
         removed_from_queue[from] = true;
         for (const Edge & edge: graph[from]) {
             Vertex to = edge.get_to();
-            DistType new_dist = dist + edge.get_weight();
+            DistType new_dist = DistTraits<DistType>::add(dist, edge.get_weight());
             if (dists[to] > new_dist) {
                 dists[to] = new_dist;
+                if (track_parents) {
+                    parents[to] = (CompactVertex)from;
+                }
                 q.emplace(to, new_dist);
             }
         }
     }
     state.pause_timing();
-    return DistsAndStatistics(dists);
+    return DistsAndStatistics(dists, parents);
 }
 
 #endif //MULTIQUEUE_DIJKSTRA_H
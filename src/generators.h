@@ -0,0 +1,272 @@
+#ifndef MULTIQUEUE_GENERATORS_H
+#define MULTIQUEUE_GENERATORS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dijkstra.h"
+#include "utils.h"
+
+// Synthetic graphs generated in parallel directly in memory, for inputs that don't have to be downloaded:
+//
+//   grid:width:height[:seed]          a road-like 2D grid, each vertex connected to its 4 neighbours in both directions
+//   rmat:scale:edge_factor[:seed]     an R-MAT power-law graph (a, b, c = 0.57, 0.19, 0.19 as in Graph500) with
+//                                     2^scale vertices and edge_factor * 2^scale arcs
+//   geometric:n:degree[:seed]         n random points in the unit square, connected in both directions if closer than
+//                                     the radius which gives the expected degree, weighted by the distance
+//   er:n:m[:seed]                     an Erdős–Rényi graph with n vertices and m uniformly random arcs
+//
+// Weights are in [1, generator_max_weight]. A graph depends only on the spec, not on the number of threads: each
+// block of vertices or arcs has its own random generator seeded from the seed and the block index, and the arcs of
+// each vertex are sorted.
+
+const DistType generator_max_weight = 1000;
+
+// splitmix64, to derive independent seeds for blocks and hash vertex pairs.
+inline uint64_t mix_seed(uint64_t seed, uint64_t stream) {
+    uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// The same weight for u -> v and v -> u.
+inline DistType symmetric_weight(uint64_t seed, Vertex u, Vertex v) {
+    return 1 + (DistType)(mix_seed(seed, ((uint64_t)std::min(u, v) << 32) ^ std::max(u, v)) % generator_max_weight);
+}
+
+inline void sort_arcs(AdjList & graph, std::size_t num_threads) {
+    parallel_for(graph.size(), num_threads, [&graph](std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            std::sort(graph[v].begin(), graph[v].end(), [](const Edge & a, const Edge & b) {
+                return a.get_to() != b.get_to() ? a.get_to() < b.get_to() : a.get_weight() < b.get_weight();
+            });
+        }
+    });
+}
+
+// num_arcs arcs from arc(random, from, to, weight), called twice per arc with the same random numbers: once to count
+// the degrees and once to place the arcs, so that the arcs are never stored twice.
+template<class F>
+AdjList generate_arcs(std::size_t num_vertexes, std::size_t num_arcs, uint64_t seed, std::size_t num_threads, F arc) {
+    const std::size_t block_size = 1 << 16;
+    std::unique_ptr<std::atomic<uint32_t>[]> degrees(new std::atomic<uint32_t>[num_vertexes]);
+    for (std::size_t v = 0; v < num_vertexes; v++) {
+        degrees[v].store(0, std::memory_order_relaxed);
+    }
+    parallel_for(num_arcs, num_threads, [&degrees, &arc, seed](std::size_t, std::size_t begin, std::size_t end) {
+        std::mt19937_64 random(mix_seed(seed, begin / block_size));
+        for (std::size_t i = begin; i < end; i++) {
+            Vertex from, to;
+            DistType weight;
+            arc(random, from, to, weight);
+            degrees[from].fetch_add(1, std::memory_order_relaxed);
+        }
+    }, block_size);
+
+    AdjList graph(num_vertexes);
+    parallel_for(num_vertexes, num_threads, [&graph, &degrees](std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            graph[v].resize(degrees[v].load(std::memory_order_relaxed), Edge(0, 0));
+            degrees[v].store(0, std::memory_order_relaxed);
+        }
+    });
+    parallel_for(num_arcs, num_threads,
+            [&graph, &degrees, &arc, seed](std::size_t, std::size_t begin, std::size_t end) {
+        std::mt19937_64 random(mix_seed(seed, begin / block_size));
+        for (std::size_t i = begin; i < end; i++) {
+            Vertex from, to;
+            DistType weight;
+            arc(random, from, to, weight);
+            graph[from][degrees[from].fetch_add(1, std::memory_order_relaxed)] = Edge(to, weight);
+        }
+    }, block_size);
+    sort_arcs(graph, num_threads);
+    return graph;
+}
+
+inline AdjList generate_grid(std::size_t width, std::size_t height, uint64_t seed,
+                             std::size_t num_threads = std::thread::hardware_concurrency()) {
+    AdjList graph(width * height);
+    parallel_for(graph.size(), num_threads,
+            [&graph, width, height, seed](std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            std::size_t row = v / width;
+            std::size_t column = v % width;
+            std::vector<Edge> & edges = graph[v];
+            edges.reserve(4);
+            if (row > 0) {
+                edges.emplace_back(v - width, symmetric_weight(seed, v, v - width));
+            }
+            if (column > 0) {
+                edges.emplace_back(v - 1, symmetric_weight(seed, v, v - 1));
+            }
+            if (column + 1 < width) {
+                edges.emplace_back(v + 1, symmetric_weight(seed, v, v + 1));
+            }
+            if (row + 1 < height) {
+                edges.emplace_back(v + width, symmetric_weight(seed, v, v + width));
+            }
+        }
+    }, 1 << 14);
+    return graph;
+}
+
+inline AdjList generate_rmat(std::size_t scale, std::size_t edge_factor, uint64_t seed,
+                             std::size_t num_threads = std::thread::hardware_concurrency()) {
+    constexpr double a = 0.57;
+    constexpr double b = 0.19;
+    constexpr double c = 0.19;
+    std::size_t num_vertexes = std::size_t(1) << scale;
+    return generate_arcs(num_vertexes, edge_factor * num_vertexes, seed, num_threads,
+            [scale](std::mt19937_64 & random, Vertex & from, Vertex & to, DistType & weight) {
+        from = 0;
+        to = 0;
+        for (std::size_t bit = 0; bit < scale; bit++) {
+            double p = (double)(random() >> 11) * 0x1.0p-53;
+            from = (from << 1) | (p >= a + b);
+            to = (to << 1) | ((p >= a && p < a + b) || p >= a + b + c);
+        }
+        weight = 1 + (DistType)(random() % generator_max_weight);
+    });
+}
+
+inline AdjList generate_erdos_renyi(std::size_t num_vertexes, std::size_t num_arcs, uint64_t seed,
+                                    std::size_t num_threads = std::thread::hardware_concurrency()) {
+    return generate_arcs(num_vertexes, num_arcs, seed, num_threads,
+            [num_vertexes](std::mt19937_64 & random, Vertex & from, Vertex & to, DistType & weight) {
+        from = random() % num_vertexes;
+        to = random() % num_vertexes;
+        weight = 1 + (DistType)(random() % generator_max_weight);
+    });
+}
+
+inline AdjList generate_geometric(std::size_t num_vertexes, double degree, uint64_t seed,
+                                  std::size_t num_threads = std::thread::hardware_concurrency()) {
+    std::vector<double> xs(num_vertexes);
+    std::vector<double> ys(num_vertexes);
+    parallel_for(num_vertexes, num_threads, [&xs, &ys, seed](std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            xs[v] = (double)(mix_seed(seed, 2 * v) >> 11) * 0x1.0p-53;
+            ys[v] = (double)(mix_seed(seed, 2 * v + 1) >> 11) * 0x1.0p-53;
+        }
+    });
+    const double pi = 3.14159265358979323846;
+    double radius = std::min(1.0, std::sqrt(degree / (pi * (double)std::max<std::size_t>(num_vertexes, 1))));
+    // Square cells of side at least radius, so that neighbours are in the 3x3 cells around a vertex, and no more cells
+    // than vertices. A zero radius (degree 0) gives one cell.
+    double max_cells_per_side = std::sqrt((double)num_vertexes) + 1;
+    auto cells_per_side = std::max<std::size_t>(
+            1, (std::size_t)(radius > 0 ? std::min(1 / radius, max_cells_per_side) : 1));
+    auto cell_of = [cells_per_side](double coordinate) {
+        return std::min(cells_per_side - 1, (std::size_t)(coordinate * (double)cells_per_side));
+    };
+    std::vector<std::size_t> cell_begin(cells_per_side * cells_per_side + 1, 0);
+    for (Vertex v = 0; v < num_vertexes; v++) {
+        cell_begin[cell_of(ys[v]) * cells_per_side + cell_of(xs[v]) + 1]++;
+    }
+    for (std::size_t i = 1; i < cell_begin.size(); i++) {
+        cell_begin[i] += cell_begin[i - 1];
+    }
+    std::vector<std::size_t> next(cell_begin.begin(), cell_begin.end() - 1);
+    std::vector<CompactVertex> cells(num_vertexes);
+    for (Vertex v = 0; v < num_vertexes; v++) {
+        cells[next[cell_of(ys[v]) * cells_per_side + cell_of(xs[v])]++] = (CompactVertex)v;
+    }
+
+    AdjList graph(num_vertexes);
+    parallel_for(num_vertexes, num_threads,
+            [&graph, &xs, &ys, &cell_begin, &cells, &cell_of, cells_per_side, radius]
+            (std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            std::size_t row = cell_of(ys[v]);
+            std::size_t column = cell_of(xs[v]);
+            for (std::size_t r = row > 0 ? row - 1 : 0; r <= std::min(row + 1, cells_per_side - 1); r++) {
+                for (std::size_t c = column > 0 ? column - 1 : 0; c <= std::min(column + 1, cells_per_side - 1); c++) {
+                    std::size_t cell = r * cells_per_side + c;
+                    for (std::size_t i = cell_begin[cell]; i < cell_begin[cell + 1]; i++) {
+                        Vertex u = cells[i];
+                        double distance = std::hypot(xs[u] - xs[v], ys[u] - ys[v]);
+                        if (u != v && distance <= radius) {
+                            auto weight = 1 + (DistType)(distance / radius * (generator_max_weight - 1));
+                            graph[v].emplace_back(u, weight);
+                        }
+                    }
+                }
+            }
+        }
+    }, 1 << 10);
+    sort_arcs(graph, num_threads);
+    return graph;
+}
+
+// True for a name of the form generator:arguments, for any generator above.
+inline bool is_generator_spec(const std::string & spec) {
+    std::string name = spec.substr(0, spec.find(':'));
+    return name.size() < spec.size() && (name == "grid" || name == "rmat" || name == "geometric" || name == "er");
+}
+
+// Throws std::invalid_argument if the spec is malformed.
+inline AdjList generate_graph(const std::string & spec, std::size_t num_threads = std::thread::hardware_concurrency()) {
+    std::vector<std::string> parts;
+    std::size_t begin = 0;
+    while (true) {
+        std::size_t end = spec.find(':', begin);
+        parts.push_back(spec.substr(begin, end - begin));
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    if (!is_generator_spec(spec) || parts.size() < 3 || parts.size() > 4) {
+        throw std::invalid_argument("expected generator:first:second[:seed], got " + spec);
+    }
+    std::vector<uint64_t> numbers;
+    for (std::size_t i = 1; i < parts.size(); i++) {
+        std::size_t parsed = 0;
+        uint64_t number = 0;
+        try {
+            number = std::stoull(parts[i], &parsed);
+        } catch (const std::logic_error &) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != parts[i].size()) {
+            throw std::invalid_argument("not a number: " + parts[i] + " in " + spec);
+        }
+        numbers.push_back(number);
+    }
+    uint64_t seed = numbers.size() == 3 ? numbers[2] : 1;
+    num_threads = std::max<std::size_t>(num_threads, 1);
+    if (parts[0] == "grid") {
+        if (numbers[0] == 0 || numbers[1] == 0) {
+            throw std::invalid_argument("no vertices: " + spec);
+        }
+        return generate_grid(numbers[0], numbers[1], seed, num_threads);
+    }
+    if (parts[0] == "rmat") {
+        if (numbers[0] >= 32) {
+            throw std::invalid_argument("rmat scale should be less than 32: " + spec);
+        }
+        return generate_rmat(numbers[0], numbers[1], seed, num_threads);
+    }
+    if (numbers[0] == 0) {
+        throw std::invalid_argument("no vertices: " + spec);
+    }
+    if (parts[0] == "geometric") {
+        if (numbers[1] == 0) {
+            throw std::invalid_argument("geometric degree should be positive: " + spec);
+        }
+        return generate_geometric(numbers[0], (double)numbers[1], seed, num_threads);
+    }
+    return generate_erdos_renyi(numbers[0], numbers[1], seed, num_threads);
+}
+
+#endif //MULTIQUEUE_GENERATORS_H
@@ -0,0 +1,332 @@
+#ifndef MULTIQUEUE_HARNESS_H
+#define MULTIQUEUE_HARNESS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "multiqueue.h"
+
+// Building blocks of the benchmark regression harness (`mq ... harness`): statistics of repeated timings, the host
+// description, and the JSON results, which are also read back as the baseline of a later run.
+//
+// The JSON puts the host and each result on a line of their own, so the baseline reader only has to parse flat
+// objects line by line. It reads the files the harness writes, not arbitrary JSON.
+
+inline double median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    std::size_t middle = values.size() / 2;
+    return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+// A bootstrap percentile interval of the median, with a fixed seed so that reruns report the same interval.
+inline std::pair<double, double> median_confidence_interval(const std::vector<double> & values,
+                                                            double confidence = 0.95,
+                                                            std::size_t num_resamples = 2000) {
+    if (values.size() < 2) {
+        double value = median(values);
+        return {value, value};
+    }
+    uint64_t seed = 1;
+    std::vector<double> medians(num_resamples);
+    std::vector<double> resample(values.size());
+    for (double & resample_median : medians) {
+        for (double & value : resample) {
+            value = values[random_fnv1a(seed) % values.size()];
+        }
+        resample_median = median(resample);
+    }
+    std::sort(medians.begin(), medians.end());
+    auto low = (std::size_t)((1 - confidence) / 2 * (double)(num_resamples - 1));
+    auto high = (std::size_t)((1 + confidence) / 2 * (double)(num_resamples - 1));
+    return {medians[low], medians[high]};
+}
+
+// The one-sided p-value of the Mann-Whitney U test that current is slower than baseline: the probability of a U at
+// least as large if both samples come from one distribution. Exact for small samples, the normal approximation
+// otherwise. A tie counts half, and U is rounded down, which only makes the test more conservative.
+inline double mann_whitney_greater_p_value(const std::vector<double> & baseline, const std::vector<double> & current) {
+    const std::size_t m = current.size();
+    const std::size_t n = baseline.size();
+    if (m == 0 || n == 0) {
+        return 1;
+    }
+    double u = 0;
+    for (double x : current) {
+        for (double y : baseline) {
+            u += x > y ? 1 : (x == y ? 0.5 : 0);
+        }
+    }
+    const std::size_t max_exact_size = 50;
+    if (m <= max_exact_size && n <= max_exact_size) {
+        // counts[i][j][k] of the orderings of i current and j baseline values with U = k, computed row by row.
+        std::vector<std::vector<double>> counts(n + 1, std::vector<double>(m * n + 1, 0));
+        for (std::size_t j = 0; j <= n; j++) {
+            counts[j][0] = 1;
+        }
+        for (std::size_t i = 1; i <= m; i++) {
+            std::vector<std::vector<double>> next(n + 1, std::vector<double>(m * n + 1, 0));
+            next[0][0] = 1;
+            for (std::size_t j = 1; j <= n; j++) {
+                for (std::size_t k = 0; k <= i * j; k++) {
+                    // The largest value is either a current one, greater than all j baseline values, or a baseline one.
+                    next[j][k] = (k >= j ? counts[j][k - j] : 0) + next[j - 1][k];
+                }
+            }
+            counts = std::move(next);
+        }
+        double total = 0;
+        double at_least = 0;
+        for (std::size_t k = 0; k <= m * n; k++) {
+            total += counts[n][k];
+            if ((double)k >= std::floor(u)) {
+                at_least += counts[n][k];
+            }
+        }
+        return at_least / total;
+    }
+    double mean = (double)m * (double)n / 2;
+    double stddev = std::sqrt((double)m * (double)n * (double)(m + n + 1) / 12);
+    double z = (std::floor(u) - 0.5 - mean) / stddev;
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+inline std::string json_escape(const std::string & value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+// The string value of key in a one-line JSON object written by the harness. Returns false if it's missing.
+inline bool read_json_string(const std::string & line, const std::string & key, std::string & value) {
+    std::string pattern = "\"" + key + "\": \"";
+    std::size_t position = line.find(pattern);
+    if (position == std::string::npos) {
+        return false;
+    }
+    value.clear();
+    for (position += pattern.size(); position < line.size() && line[position] != '"'; position++) {
+        if (line[position] == '\\' && position + 1 < line.size()) {
+            position++;
+        }
+        value += line[position];
+    }
+    return position < line.size();
+}
+
+// The numbers of key, which is a number or an array of numbers.
+inline bool read_json_numbers(const std::string & line, const std::string & key, std::vector<double> & values) {
+    std::string pattern = "\"" + key + "\": ";
+    std::size_t position = line.find(pattern);
+    if (position == std::string::npos) {
+        return false;
+    }
+    position += pattern.size();
+    bool array = position < line.size() && line[position] == '[';
+    std::size_t end = array ? line.find(']', position) : line.find_first_of(",}", position);
+    if (end == std::string::npos) {
+        return false;
+    }
+    std::string numbers = line.substr(position + (array ? 1 : 0), end - position - (array ? 1 : 0));
+    std::replace(numbers.begin(), numbers.end(), ',', ' ');
+    std::istringstream input(numbers);
+    values.clear();
+    double value;
+    while (input >> value) {
+        values.push_back(value);
+    }
+    return input.eof();
+}
+
+class HostTopology {
+public:
+    std::string cpu_model = "unknown";
+    std::size_t hardware_threads = 0;
+    std::size_t num_cores = 0;
+    std::size_t num_sockets = 0;
+    std::size_t num_numa_nodes = 0;
+    std::string caches;
+    std::string compiler;
+
+    // From /proc/cpuinfo and /sys on Linux, the fields stay unknown or 0 elsewhere.
+    static HostTopology detect() {
+        HostTopology host;
+        host.hardware_threads = std::thread::hardware_concurrency();
+        std::ifstream cpuinfo("/proc/cpuinfo");
+        std::string line;
+        std::string physical_id = "0";
+        std::set<std::string> sockets;
+        std::set<std::string> cores;
+        auto value_of = [](const std::string & line) {
+            std::size_t colon = line.find(':');
+            return colon == std::string::npos || colon + 2 > line.size() ? std::string() : line.substr(colon + 2);
+        };
+        while (std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") == 0) {
+                host.cpu_model = value_of(line);
+            } else if (line.compare(0, 11, "physical id") == 0) {
+                physical_id = value_of(line);
+                sockets.insert(physical_id);
+            } else if (line.compare(0, 7, "core id") == 0) {
+                cores.insert(physical_id + ":" + value_of(line));
+            }
+        }
+        host.num_sockets = std::max<std::size_t>(sockets.size(), 1);
+        host.num_cores = cores.empty() ? host.hardware_threads : cores.size();
+        while (std::ifstream("/sys/devices/system/node/node" + std::to_string(host.num_numa_nodes) + "/cpulist")) {
+            host.num_numa_nodes++;
+        }
+        host.num_numa_nodes = std::max<std::size_t>(host.num_numa_nodes, 1);
+        for (int index = 0; ; index++) {
+            std::string prefix = "/sys/devices/system/cpu/cpu0/cache/index" + std::to_string(index) + "/";
+            std::ifstream level_input(prefix + "level");
+            std::string level, type, size;
+            if (!(level_input >> level)) {
+                break;
+            }
+            std::ifstream(prefix + "type") >> type;
+            std::ifstream(prefix + "size") >> size;
+            std::string name = "L" + level + (type == "Data" ? "d" : (type == "Instruction" ? "i" : ""));
+            host.caches += (host.caches.empty() ? "" : " ") + name + " " + size;
+        }
+#ifdef __VERSION__
+        host.compiler = __VERSION__;
+#endif
+        return host;
+    }
+
+    std::string to_json() const {
+        std::ostringstream output;
+        output << "{\"cpu\": \"" << json_escape(cpu_model) << "\", \"hardware_threads\": " << hardware_threads
+               << ", \"cores\": " << num_cores << ", \"sockets\": " << num_sockets << ", \"numa_nodes\": "
+               << num_numa_nodes << ", \"caches\": \"" << json_escape(caches) << "\", \"compiler\": \""
+               << json_escape(compiler) << "\"}";
+        return output.str();
+    }
+    static bool from_json(const std::string & line, HostTopology & host) {
+        std::vector<double> threads;
+        if (!read_json_string(line, "cpu", host.cpu_model) || !read_json_numbers(line, "hardware_threads", threads)
+                || threads.empty()) {
+            return false;
+        }
+        host.hardware_threads = (std::size_t)threads[0];
+        return true;
+    }
+};
+
+// The timings of one engine on one graph.
+class HarnessResult {
+public:
+    std::string graph;
+    std::string engine;
+    std::vector<double> times_ms;
+    bool ok = true;
+    // Over the median of the fastest sequential engine on the same graph, speedup_over, 0 without one.
+    double speedup = 0;
+    std::string speedup_over;
+
+    double get_median_ms() const {
+        return median(times_ms);
+    }
+    std::string to_json() const {
+        std::pair<double, double> interval = median_confidence_interval(times_ms);
+        std::ostringstream output;
+        output << std::fixed << std::setprecision(3);
+        output << "{\"graph\": \"" << json_escape(graph) << "\", \"engine\": \"" << json_escape(engine)
+               << "\", \"ok\": " << (ok ? "true" : "false") << ", \"median_ms\": " << get_median_ms()
+               << ", \"ci_low_ms\": " << interval.first << ", \"ci_high_ms\": " << interval.second
+               << ", \"speedup\": " << speedup << ", \"speedup_over\": \"" << json_escape(speedup_over)
+               << "\", \"times_ms\": [";
+        for (std::size_t i = 0; i < times_ms.size(); i++) {
+            output << (i == 0 ? "" : ", ") << times_ms[i];
+        }
+        output << "]}";
+        return output.str();
+    }
+    static bool from_json(const std::string & line, HarnessResult & result) {
+        return read_json_string(line, "graph", result.graph) && read_json_string(line, "engine", result.engine)
+               && read_json_numbers(line, "times_ms", result.times_ms);
+    }
+};
+
+inline void write_harness_json(std::ostream & output, const HostTopology & host, const std::string & config_json,
+                               const std::vector<HarnessResult> & results) {
+    output << "{\n\"host\": " << host.to_json() << ",\n\"config\": " << config_json << ",\n\"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        output << results[i].to_json() << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    output << "]\n}\n";
+}
+
+// Reads the results and the host of a file written by write_harness_json. Returns false if it has no results.
+inline bool read_harness_json(std::istream & input, HostTopology & host, std::vector<HarnessResult> & results) {
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.compare(0, 8, "\"host\": ") == 0) {
+            HostTopology::from_json(line, host);
+            continue;
+        }
+        HarnessResult result;
+        if (HarnessResult::from_json(line, result)) {
+            results.push_back(result);
+        }
+    }
+    return !results.empty();
+}
+
+class HarnessComparison {
+public:
+    std::string graph;
+    std::string engine;
+    double baseline_median_ms = 0;
+    double current_median_ms = 0;
+    double p_value = 1;
+    // Significantly slower and by more than the tolerance.
+    bool regression = false;
+};
+
+// Compares the results found in the baseline. A regression needs both a p-value below alpha and a median slower by
+// more than tolerance, e.g. 0.05 for 5%, so that a significant but negligible slowdown doesn't fail the run.
+inline std::vector<HarnessComparison> compare_with_baseline(const std::vector<HarnessResult> & baseline,
+                                                            const std::vector<HarnessResult> & current,
+                                                            double alpha, double tolerance) {
+    std::vector<HarnessComparison> comparisons;
+    for (const HarnessResult & result : current) {
+        auto found = std::find_if(baseline.begin(), baseline.end(), [&result](const HarnessResult & o) {
+            return o.graph == result.graph && o.engine == result.engine;
+        });
+        if (found == baseline.end()) {
+            continue;
+        }
+        HarnessComparison comparison;
+        comparison.graph = result.graph;
+        comparison.engine = result.engine;
+        comparison.baseline_median_ms = found->get_median_ms();
+        comparison.current_median_ms = result.get_median_ms();
+        comparison.p_value = mann_whitney_greater_p_value(found->times_ms, result.times_ms);
+        comparison.regression = comparison.p_value < alpha
+                                && comparison.current_median_ms > comparison.baseline_median_ms * (1 + tolerance);
+        comparisons.push_back(comparison);
+    }
+    return comparisons;
+}
+
+#endif //MULTIQUEUE_HARNESS_H
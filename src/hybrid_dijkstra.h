@@ -0,0 +1,263 @@
+#ifndef MULTIQUEUE_HYBRID_DIJKSTRA_H
+#define MULTIQUEUE_HYBRID_DIJKSTRA_H
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/barrier.hpp>
+
+#include "dijkstra.h"
+#include "multiqueue.h"
+#include "utils.h"
+
+// A Dijkstra which runs sequentially while the frontier is small and switches to the Multiqueue threads once it grows.
+//
+// On road graphs the frontier stays small for most of a run, too small to keep all threads busy, and threads only
+// pay for contention and wasted work then. calc_dijkstra_hybrid starts with the calling thread popping an exact
+// d-ary heap without locks. When the heap holds parallel_threshold elements, they move to the Multiqueue and
+// num_threads threads take over: the calling thread and num_threads - 1 threads which are started once per run and
+// wait on a barrier while the heap is sequential. Each thread counts the elements it adds minus the elements it pops
+// and publishes the count in its own shard every hybrid_check_interval pops and when it leaves; it then sums the
+// shards, and when fewer than parallel_threshold / hybrid_hysteresis elements are left, the threads stop and the rest
+// moves back to the sequential heap. The hysteresis keeps a frontier around the threshold from switching all the
+// time. The shards are written rarely and there are num_threads of them, so the check doesn't touch the sub-queues,
+// which stay uninstrumented for the other engines.
+//
+// Both modes work on the same QueueElements, which hold the distances, parents and heap positions, so a switch only
+// moves the pointers of the frontier, not the per-vertex state.
+const std::size_t hybrid_check_interval = 64;
+const std::size_t hybrid_hysteresis = 2;
+
+// q_id of the elements in the sequential heap, never seen by the Multiqueue.
+const int sequential_q_id = -2;
+
+// Elements added minus elements popped by one thread, on a cache line of its own.
+struct alignas(128) HybridSizeShard {
+    std::atomic<int64_t> delta{0};
+};
+
+template<class Queue, class Graph = AdjList>
+void hybrid_thread_routine(const Graph & graph, Queue & queue, std::vector<typename Queue::Element> & vertexes,
+                           std::atomic<bool> & stop, std::vector<HybridSizeShard> & shards, std::size_t thread_id,
+                           int64_t initial_size, int64_t sequential_threshold, std::atomic<std::size_t> & num_pops) {
+    using Element = typename Queue::Element;
+    using Dist = typename Element::dist_type;
+    std::size_t thread_pops = 0;
+    int64_t delta = 0;
+    while (!stop.load(std::memory_order_relaxed)) {
+        Element * elem = queue.pop();
+        if (elem == &Element::empty_element) {
+            break;
+        }
+        thread_pops++;
+        delta--;
+        const Vertex v = elem->vertex;
+        for (Edge e : graph[v]) {
+            Vertex to = e.get_to();
+            if (v == to) {
+                continue;
+            }
+            // relax_arc, counting the pushes which add an element
+            while (true) {
+                Dist new_dist = DistTraits<Dist>::add(elem->get_dist_relaxed(), (Dist)e.get_weight());
+                if (vertexes[to].get_dist_relaxed() <= new_dist) {
+                    break;
+                }
+                if (queue.push(&vertexes[to], new_dist, (CompactVertex)v)) {
+                    delta++;
+                }
+            }
+        }
+        if (thread_pops % hybrid_check_interval == 0) {
+            shards[thread_id].delta.store(delta, std::memory_order_relaxed);
+            int64_t size = initial_size;
+            for (const HybridSizeShard & shard : shards) {
+                size += shard.delta.load(std::memory_order_relaxed);
+            }
+            if (size < sequential_threshold) {
+                stop.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+    shards[thread_id].delta.store(delta, std::memory_order_relaxed);
+    num_pops += thread_pops;
+}
+
+// The threads of the parallel phases of one run. The calling thread is worker 0 and the others wait on the barrier
+// between the phases, so a switch doesn't create threads.
+template<class Queue, class Graph>
+class HybridWorkers {
+    using Element = typename Queue::Element;
+
+    const Graph & graph;
+    Queue & queue;
+    std::vector<Element> & vertexes;
+    const int64_t sequential_threshold;
+    boost::barrier barrier;
+    std::atomic<bool> done{false};
+    bool in_phase = false;
+    std::atomic<bool> stop{false};
+    std::vector<HybridSizeShard> shards;
+    int64_t initial_size = 0;
+    std::atomic<std::size_t> num_pops{0};
+    std::vector<std::thread> threads;
+    cpu_set_t affinity;
+
+    void run_phase(std::size_t thread_id) {
+        hybrid_thread_routine<Queue, Graph>(graph, queue, vertexes, stop, shards, thread_id, initial_size,
+                                            sequential_threshold, num_pops);
+    }
+
+public:
+    HybridWorkers(const Graph & graph, Queue & queue, std::vector<Element> & vertexes, std::size_t num_threads,
+                  int64_t sequential_threshold)
+            : graph(graph), queue(queue), vertexes(vertexes), sequential_threshold(sequential_threshold),
+              barrier(num_threads), shards(num_threads) {
+        for (std::size_t thread_id = 1; thread_id < num_threads; thread_id++) {
+            threads.emplace_back([this, thread_id]() {
+                // Each phase is between two waits.
+                while (true) {
+                    barrier.wait();
+                    if (done.load()) {
+                        break;
+                    }
+                    run_phase(thread_id);
+                    barrier.wait();
+                }
+            });
+            pin_thread(thread_id, threads.back());
+        }
+        affinity = pin_current_thread(0);
+    }
+    HybridWorkers(const HybridWorkers &) = delete;
+    HybridWorkers & operator=(const HybridWorkers &) = delete;
+    // Lets the other threads exit. If the calling thread throws in a phase, the others finish the phase first.
+    ~HybridWorkers() {
+        stop.store(true);
+        if (in_phase) {
+            barrier.wait();
+        }
+        done.store(true);
+        barrier.wait();
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+        set_current_thread_affinity(affinity);
+    }
+    // Pops the Multiqueue, which holds initial_size elements, with all threads until it gets small.
+    void run(int64_t new_initial_size) {
+        initial_size = new_initial_size;
+        stop.store(false);
+        for (HybridSizeShard & shard : shards) {
+            shard.delta.store(0, std::memory_order_relaxed);
+        }
+        in_phase = true;
+        barrier.wait();
+        run_phase(0);
+        barrier.wait();
+        in_phase = false;
+    }
+    std::size_t get_num_pops() const {
+        return num_pops.load();
+    }
+};
+
+// Adds the number of switches between the modes to num_switches if it isn't null.
+template<class Queue = Multiqueue, class Graph = AdjList>
+DistsAndStatistics calc_dijkstra_hybrid(const Graph & graph, std::size_t num_threads, int size_multiple,
+                                        std::size_t one_queue_reserve_size, std::size_t parallel_threshold,
+                                        Timer & state, bool track_parents = false,
+                                        std::size_t * num_switches = nullptr) {
+    using Element = typename Queue::Element;
+    using Dist = typename Element::dist_type;
+    const Vertex start_vertex = 0;
+    const std::size_t num_vertexes = graph.size();
+    parallel_threshold = std::max<std::size_t>(parallel_threshold, 1);
+    num_threads = std::max<std::size_t>(num_threads, 1);
+    Queue queue(num_threads, size_multiple, one_queue_reserve_size);
+    std::vector<Element> vertexes;
+    vertexes.reserve(num_vertexes);
+    for (std::size_t i = 0; i < num_vertexes; i++) {
+        vertexes.emplace_back(i);
+    }
+    // Holds each element once at most, so it never grows past num_vertexes.
+    my_d_ary_heap<8, Element> heap(std::max<std::size_t>(num_vertexes, 1));
+    std::size_t heap_size = 0;
+    std::size_t switches = 0;
+    HybridWorkers<Queue, Graph> workers(graph, queue, vertexes, num_threads,
+                                        (int64_t)(parallel_threshold / hybrid_hysteresis));
+
+    state.resume_timing();
+    if (num_vertexes > 0) {
+        vertexes[start_vertex].set_dist_relaxed(0);
+        heap.push(&vertexes[start_vertex]);
+        vertexes[start_vertex].set_q_id_relaxed(sequential_q_id);
+        heap_size = 1;
+    }
+    std::size_t sequential_pops = 0;
+    while (true) {
+        while (heap_size > 0 && heap_size < parallel_threshold) {
+            Element * elem = heap.top();
+            heap.pop();
+            heap_size--;
+            elem->set_q_id_relaxed(-1);
+            sequential_pops++;
+            const Vertex v = elem->vertex;
+            const Dist dist = elem->get_dist_relaxed();
+            for (Edge e : graph[v]) {
+                Element & to = vertexes[e.get_to()];
+                Dist new_dist = DistTraits<Dist>::add(dist, (Dist)e.get_weight());
+                if (new_dist >= to.get_dist_relaxed()) {
+                    continue;
+                }
+                if (to.get_q_id_relaxed() == sequential_q_id) {
+                    heap.decrease_key(&to, new_dist);
+                } else {
+                    to.set_dist_relaxed(new_dist);
+                    heap.push(&to);
+                    to.set_q_id_relaxed(sequential_q_id);
+                    heap_size++;
+                }
+                to.set_parent_relaxed((CompactVertex)v);
+            }
+        }
+        if (heap_size == 0) {
+            break;
+        }
+
+        const auto initial_size = (int64_t)heap_size;
+        while (!heap.empty()) {
+            Element * elem = heap.top();
+            heap.pop();
+            queue.push_singlethreaded(elem, elem->get_dist_relaxed(), elem->get_parent_relaxed());
+        }
+        heap_size = 0;
+        workers.run(initial_size);
+        queue.pop_all_singlethreaded([&heap, &heap_size](Element * elem) {
+            heap.push(elem);
+            elem->set_q_id_relaxed(sequential_q_id);
+            heap_size++;
+        });
+        switches += 2;
+    }
+    state.pause_timing();
+
+    std::vector<Dist> dists(num_vertexes);
+    ParentVector parents(track_parents ? num_vertexes : 0);
+    for (std::size_t i = 0; i < num_vertexes; i++) {
+        dists[i] = vertexes[i].get_dist();
+        if (track_parents) {
+            parents[i] = vertexes[i].get_parent_relaxed();
+        }
+    }
+    DistsAndStatistics result(to_dist_vector(std::move(dists)), std::move(parents));
+    result.set_num_pops(sequential_pops + workers.get_num_pops());
+    if (num_switches != nullptr) {
+        *num_switches += switches;
+    }
+    return result;
+}
+
+#endif //MULTIQUEUE_HYBRID_DIJKSTRA_H
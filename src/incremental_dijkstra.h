@@ -0,0 +1,268 @@
+#ifndef MULTIQUEUE_INCREMENTAL_DIJKSTRA_H
+#define MULTIQUEUE_INCREMENTAL_DIJKSTRA_H
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/barrier.hpp>
+
+#include "dijkstra.h"
+#include "multiqueue.h"
+#include "utils.h"
+
+// Shortest paths from one vertex kept up to date while edge weights change, e.g. by traffic updates.
+//
+// The QueueElements (distance and parent of each vertex) and the Multiqueue outlive a computation. After a batch of
+// weight changes, the vertices whose parent arc got longer lose their distances together with their subtrees in the
+// shortest path tree. Those vertices are seeded with the best distance over their incoming arcs from the vertices
+// which kept their distances, the heads of shortened arcs are seeded if they improve, and the parallel Dijkstra
+// continues from the seeds. Only the affected region is visited.
+
+class EdgeWeightChange {
+public:
+    EdgeWeightChange(Vertex from, Vertex to, DistType weight) : from(from), to(to), weight(weight) {}
+    Vertex from;
+    Vertex to;
+    // The new weight of all arcs from -> to.
+    DistType weight;
+};
+
+class UpdateStatistics {
+public:
+    // Vertices which lost their distances because of increases.
+    std::size_t num_invalidated = 0;
+    // Vertices the parallel Dijkstra was restarted from.
+    std::size_t num_seeded = 0;
+};
+
+template<class Queue = Multiqueue>
+class IncrementalDijkstra {
+private:
+    using Element = typename Queue::Element;
+    // The arc graph[from][index].
+    class InArc {
+    public:
+        InArc(CompactVertex from, uint32_t index) : from(from), index(index) {}
+        CompactVertex from;
+        uint32_t index;
+    };
+    static constexpr DistType infinity = std::numeric_limits<DistType>::max();
+
+    AdjList graph;
+    const std::size_t num_threads;
+    const Vertex start_vertex;
+    Queue queue;
+    std::vector<Element> vertexes;
+    std::vector<std::size_t> in_begin;
+    std::vector<InArc> in_arcs;
+    std::vector<char> invalidated;
+
+    void run_threads(Timer & state) {
+        std::vector<std::thread> threads;
+        boost::barrier barrier(num_threads);
+        for (std::size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+            threads.emplace_back(dijkstra_thread_routine<Queue>, std::cref(graph), std::ref(queue),
+                                 std::ref(vertexes), std::ref(state), std::ref(barrier), thread_id, nullptr);
+            pin_thread(thread_id, threads.back());
+        }
+        for (std::thread & thread : threads) {
+            thread.join();
+        }
+    }
+
+    DistType get_min_weight(Vertex from, Vertex to) const {
+        DistType weight = infinity;
+        for (const Edge & edge : graph[from]) {
+            if (edge.get_to() == to) {
+                weight = std::min(weight, edge.get_weight());
+            }
+        }
+        return weight;
+    }
+
+public:
+    // Computes the distances from start_vertex, untimed.
+    IncrementalDijkstra(AdjList graph, std::size_t num_threads, int size_multiple, std::size_t one_queue_reserve_size,
+                        Vertex start_vertex = 0)
+            : graph(std::move(graph)), num_threads(num_threads), start_vertex(start_vertex),
+              queue(num_threads, size_multiple, one_queue_reserve_size),
+              invalidated(this->graph.size(), false) {
+        std::size_t num_vertexes = this->graph.size();
+        vertexes.reserve(num_vertexes);
+        for (std::size_t i = 0; i < num_vertexes; i++) {
+            vertexes.emplace_back(i);
+        }
+        in_begin.assign(num_vertexes + 1, 0);
+        for (const auto & edges : this->graph) {
+            for (const Edge & edge : edges) {
+                in_begin[edge.get_to() + 1]++;
+            }
+        }
+        for (std::size_t v = 0; v < num_vertexes; v++) {
+            in_begin[v + 1] += in_begin[v];
+        }
+        std::vector<std::size_t> next(in_begin.begin(), in_begin.end() - 1);
+        in_arcs.resize(in_begin.back(), InArc(0, 0));
+        for (Vertex from = 0; from < num_vertexes; from++) {
+            for (std::size_t i = 0; i < this->graph[from].size(); i++) {
+                in_arcs[next[this->graph[from][i].get_to()]++] = InArc((CompactVertex)from, (uint32_t)i);
+            }
+        }
+        if (num_vertexes > 0) {
+            Timer untimed;
+            queue.push_singlethreaded(&vertexes[start_vertex], 0);
+            run_threads(untimed);
+        }
+    }
+
+    const AdjList & get_graph() const {
+        return graph;
+    }
+    DistVector get_dists() const {
+        DistVector dists(vertexes.size());
+        for (std::size_t i = 0; i < vertexes.size(); i++) {
+            dists[i] = vertexes[i].get_dist_relaxed();
+        }
+        return dists;
+    }
+    ParentVector get_parents() const {
+        ParentVector parents(vertexes.size());
+        for (std::size_t i = 0; i < vertexes.size(); i++) {
+            parents[i] = vertexes[i].get_parent_relaxed();
+        }
+        return parents;
+    }
+
+    // Applies the changes to the graph, the last change of an arc wins, and repairs the distances and parents.
+    // Throws std::invalid_argument, before changing anything, if an arc doesn't exist or a weight isn't positive.
+    UpdateStatistics update(const std::vector<EdgeWeightChange> & changes, Timer & state) {
+        for (const EdgeWeightChange & change : changes) {
+            if (change.weight <= 0) {
+                throw std::invalid_argument("non-positive weight " + std::to_string(change.weight));
+            }
+            if (change.from >= graph.size() || get_min_weight(change.from, change.to) == infinity) {
+                throw std::invalid_argument("no arc " + std::to_string(change.from) + " -> "
+                                            + std::to_string(change.to));
+            }
+        }
+        UpdateStatistics statistics;
+        state.resume_timing();
+        for (const EdgeWeightChange & change : changes) {
+            for (Edge & edge : graph[change.from]) {
+                if (edge.get_to() == change.to) {
+                    edge.set_weight(change.weight);
+                }
+            }
+        }
+
+        // The subtrees under broken parent arcs, found by following the arcs to children.
+        std::vector<Vertex> invalid;
+        for (const EdgeWeightChange & change : changes) {
+            Element & to = vertexes[change.to];
+            if (to.get_parent_relaxed() != change.from || invalidated[change.to]) {
+                continue;
+            }
+            DistType from_dist = vertexes[change.from].get_dist_relaxed();
+            if (from_dist + get_min_weight(change.from, change.to) > to.get_dist_relaxed()) {
+                invalidated[change.to] = true;
+                invalid.push_back(change.to);
+            }
+        }
+        for (std::size_t i = 0; i < invalid.size(); i++) {
+            Vertex v = invalid[i];
+            for (const Edge & edge : graph[v]) {
+                Vertex child = edge.get_to();
+                if (!invalidated[child] && vertexes[child].get_parent_relaxed() == v) {
+                    invalidated[child] = true;
+                    invalid.push_back(child);
+                }
+            }
+        }
+        for (Vertex v : invalid) {
+            vertexes[v].set_dist_relaxed(infinity);
+            vertexes[v].set_parent_relaxed(no_parent);
+        }
+        statistics.num_invalidated = invalid.size();
+
+        for (Vertex v : invalid) {
+            DistType best_dist = infinity;
+            CompactVertex best_parent = no_parent;
+            for (std::size_t i = in_begin[v]; i < in_begin[v + 1]; i++) {
+                const InArc & arc = in_arcs[i];
+                DistType from_dist = vertexes[arc.from].get_dist_relaxed();
+                if (invalidated[arc.from] || from_dist == infinity) {
+                    continue;
+                }
+                DistType dist = from_dist + graph[arc.from][arc.index].get_weight();
+                if (dist < best_dist) {
+                    best_dist = dist;
+                    best_parent = arc.from;
+                }
+            }
+            if (best_dist != infinity) {
+                queue.push(&vertexes[v], best_dist, best_parent);
+                statistics.num_seeded++;
+            }
+        }
+        for (const EdgeWeightChange & change : changes) {
+            DistType from_dist = vertexes[change.from].get_dist_relaxed();
+            if (invalidated[change.from] || from_dist == infinity) {
+                continue;
+            }
+            DistType dist = from_dist + get_min_weight(change.from, change.to);
+            if (dist < vertexes[change.to].get_dist_relaxed()) {
+                queue.push(&vertexes[change.to], dist, (CompactVertex)change.from);
+                statistics.num_seeded++;
+            }
+        }
+        for (Vertex v : invalid) {
+            invalidated[v] = false;
+        }
+        state.pause_timing();
+
+        run_threads(state);
+        return statistics;
+    }
+};
+
+// A traffic-like batch: batch_size random arcs get twice or half (at least 1) of their weight.
+inline std::vector<EdgeWeightChange> random_weight_changes(const AdjList & graph, std::size_t batch_size,
+                                                           uint64_t seed) {
+    std::vector<EdgeWeightChange> changes;
+    if (graph.empty()) {
+        return changes;
+    }
+    for (std::size_t tries = 0; changes.size() < batch_size && tries < 100 * batch_size; tries++) {
+        Vertex from = random_fnv1a(seed) % graph.size();
+        if (graph[from].empty()) {
+            continue;
+        }
+        const Edge & edge = graph[from][random_fnv1a(seed) % graph[from].size()];
+        DistType weight = random_fnv1a(seed) % 2 == 0 ? edge.get_weight() * 2 : std::max(1, edge.get_weight() / 2);
+        changes.emplace_back(from, edge.get_to(), weight);
+    }
+    return changes;
+}
+
+// Changes back to the smallest weight of each arc in graph, which restores the distances in graph.
+inline std::vector<EdgeWeightChange> reverted_weight_changes(const AdjList & graph,
+                                                             const std::vector<EdgeWeightChange> & changes) {
+    std::vector<EdgeWeightChange> reverted;
+    for (const EdgeWeightChange & change : changes) {
+        DistType weight = std::numeric_limits<DistType>::max();
+        for (const Edge & edge : graph[change.from]) {
+            if (edge.get_to() == change.to) {
+                weight = std::min(weight, edge.get_weight());
+            }
+        }
+        reverted.emplace_back(change.from, change.to, weight);
+    }
+    return reverted;
+}
+
+#endif //MULTIQUEUE_INCREMENTAL_DIJKSTRA_H
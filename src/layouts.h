@@ -0,0 +1,71 @@
+#ifndef MULTIQUEUE_LAYOUTS_H
+#define MULTIQUEUE_LAYOUTS_H
+
+#include <string>
+
+#include "binary_heap.h"
+#include "multiqueue.h"
+
+// Maps the layout names used in params files to Multiqueue instantiations, so that every layout is compiled into
+// one binary and selected per parameter line.
+//
+// Both sub-queues and QueueElements accept: not_padded, padded64, padded128, aligned64, aligned128.
+
+const std::string default_queue_layout = "padded128";
+const std::string default_element_layout = "padded128";
+
+template<class T>
+struct LayoutTag {
+    using type = T;
+};
+
+// Calls f(LayoutTag<Element>()) and returns true, or returns false if the layout name is unknown.
+template<class F>
+bool with_element_layout(const std::string & element_layout, F && f) {
+    if (element_layout == "not_padded") {
+        f(LayoutTag<BasicQueueElement<element_not_padded>>());
+    } else if (element_layout == "padded64") {
+        f(LayoutTag<BasicQueueElement<element_padded<64>>>());
+    } else if (element_layout == "padded128") {
+        f(LayoutTag<BasicQueueElement<element_padded<128>>>());
+    } else if (element_layout == "aligned64") {
+        f(LayoutTag<BasicQueueElement<element_aligned<64>>>());
+    } else if (element_layout == "aligned128") {
+        f(LayoutTag<BasicQueueElement<element_aligned<128>>>());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Calls f(LayoutTag<Multiqueue>()) and returns true, or returns false if the layout name is unknown.
+template<class Element, class F>
+bool with_queue_layout(const std::string & queue_layout, F && f) {
+    using Heap = my_d_ary_heap<8, Element>;
+    if (queue_layout == "not_padded") {
+        f(LayoutTag<BasicMultiqueue<not_padded<Heap>>>());
+    } else if (queue_layout == "padded64") {
+        f(LayoutTag<BasicMultiqueue<padded<Heap, 64>>>());
+    } else if (queue_layout == "padded128") {
+        f(LayoutTag<BasicMultiqueue<padded<Heap, 128>>>());
+    } else if (queue_layout == "aligned64") {
+        f(LayoutTag<BasicMultiqueue<aligned<Heap, 64>>>());
+    } else if (queue_layout == "aligned128") {
+        f(LayoutTag<BasicMultiqueue<aligned<Heap, 128>>>());
+    } else {
+        return false;
+    }
+    return true;
+}
+
+template<class F>
+bool with_multiqueue_layout(const std::string & queue_layout, const std::string & element_layout, F && f) {
+    bool known_queue_layout = true;
+    bool known_element_layout = with_element_layout(element_layout, [&queue_layout, &f, &known_queue_layout](auto tag) {
+        using Element = typename decltype(tag)::type;
+        known_queue_layout = with_queue_layout<Element>(queue_layout, f);
+    });
+    return known_element_layout && known_queue_layout;
+}
+
+#endif //MULTIQUEUE_LAYOUTS_H
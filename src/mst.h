@@ -0,0 +1,278 @@
+#ifndef MULTIQUEUE_MST_H
+#define MULTIQUEUE_MST_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include "dijkstra.h"
+#include "search_space.h"
+#include "utils.h"
+
+// Minimum spanning forests of a graph whose arcs are taken as undirected edges (see make_undirected).
+//
+// calc_mst_kruskal is the sequential reference. calc_mst_boruvka is the parallel baseline: in each round, every
+// component picks its lightest outgoing edge and the picked edges are merged. calc_mst_prim first grows disjoint Prim
+// fragments in parallel (Bader and Cong, 2005): each thread grows fragments with its own d-ary heap and decrease_key,
+// and stops a fragment when its lightest outgoing edge leads to another fragment. Every such edge is the lightest edge
+// leaving its fragment, so it belongs to a minimum spanning forest; Borůvka then merges the fragments.
+//
+// The Prim fragments don't share the Multiqueue: a relaxed pop could return an edge which isn't the lightest leaving
+// the tree, and Prim can't take an edge back.
+
+class MSTResult {
+public:
+    int64_t total_weight = 0;
+    std::size_t num_edges = 0;
+    bool operator==(const MSTResult & o) const {
+        return total_weight == o.total_weight && num_edges == o.num_edges;
+    }
+    bool operator!=(const MSTResult & o) const {
+        return !(*this == o);
+    }
+};
+
+// Each arc u -> v also becomes v -> u, parallel arcs and loops are dropped, the lightest parallel arc stays.
+inline AdjList make_undirected(const AdjList & graph) {
+    AdjList undirected(graph.size());
+    for (Vertex from = 0; from < graph.size(); from++) {
+        for (const Edge & edge : graph[from]) {
+            if (edge.get_to() != from) {
+                undirected[from].push_back(edge);
+                undirected[edge.get_to()].emplace_back(from, edge.get_weight());
+            }
+        }
+    }
+    for (auto & edges : undirected) {
+        std::sort(edges.begin(), edges.end(), [](const Edge & a, const Edge & b) {
+            return a.get_to() != b.get_to() ? a.get_to() < b.get_to() : a.get_weight() < b.get_weight();
+        });
+        edges.erase(std::unique(edges.begin(), edges.end(), [](const Edge & a, const Edge & b) {
+            return a.get_to() == b.get_to();
+        }), edges.end());
+    }
+    return undirected;
+}
+
+class DisjointSets {
+private:
+    std::vector<CompactVertex> parents;
+public:
+    explicit DisjointSets(std::size_t size) : parents(size) {
+        std::iota(parents.begin(), parents.end(), 0);
+    }
+    Vertex find(Vertex v) {
+        while (parents[v] != v) {
+            parents[v] = parents[parents[v]];
+            v = parents[v];
+        }
+        return v;
+    }
+    // Doesn't compress the paths, so it can be called in parallel as long as nothing is merged.
+    Vertex find_const(Vertex v) const {
+        while (parents[v] != v) {
+            v = parents[v];
+        }
+        return v;
+    }
+    // Returns false if u and v are in one set already.
+    bool merge(Vertex u, Vertex v) {
+        u = find(u);
+        v = find(v);
+        if (u == v) {
+            return false;
+        }
+        parents[std::max(u, v)] = (CompactVertex)std::min(u, v);
+        return true;
+    }
+    void set_parent(Vertex v, Vertex parent) {
+        parents[v] = (CompactVertex)parent;
+    }
+};
+
+inline MSTResult calc_mst_kruskal(const AdjList & graph, Timer & state) {
+    class WeightedEdge {
+    public:
+        DistType weight;
+        CompactVertex from;
+        CompactVertex to;
+    };
+    std::vector<WeightedEdge> edges;
+    state.resume_timing();
+    for (Vertex from = 0; from < graph.size(); from++) {
+        for (const Edge & edge : graph[from]) {
+            if (from < edge.get_to()) {
+                edges.push_back({edge.get_weight(), (CompactVertex)from, (CompactVertex)edge.get_to()});
+            }
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const WeightedEdge & a, const WeightedEdge & b) {
+        return a.weight < b.weight;
+    });
+    DisjointSets sets(graph.size());
+    MSTResult result;
+    for (const WeightedEdge & edge : edges) {
+        if (sets.merge(edge.from, edge.to)) {
+            result.total_weight += edge.weight;
+            result.num_edges++;
+        }
+    }
+    state.pause_timing();
+    return result;
+}
+
+// Borůvka rounds starting from the components in sets. Adds the merged edges to result.
+inline void boruvka_rounds(const AdjList & graph, std::size_t num_threads, DisjointSets & sets, MSTResult & result) {
+    const std::size_t num_vertexes = graph.size();
+    const uint64_t no_edge = std::numeric_limits<uint64_t>::max();
+    // The lightest outgoing edge of each component as weight << 32 | the vertex of the component it starts at.
+    std::unique_ptr<std::atomic<uint64_t>[]> lightest(new std::atomic<uint64_t>[num_vertexes]);
+    std::vector<CompactVertex> components(num_vertexes);
+    std::vector<Vertex> roots;
+    std::vector<Vertex> merged_from;
+    std::vector<Vertex> merged_to;
+    while (true) {
+        parallel_for(num_vertexes, num_threads,
+                [&sets, &components, &lightest, no_edge](std::size_t, std::size_t begin, std::size_t end) {
+            for (Vertex v = begin; v < end; v++) {
+                components[v] = (CompactVertex)sets.find_const(v);
+                lightest[v].store(no_edge, std::memory_order_relaxed);
+            }
+        });
+        parallel_for(num_vertexes, num_threads,
+                [&sets, &components](std::size_t, std::size_t begin, std::size_t end) {
+            for (Vertex v = begin; v < end; v++) {
+                sets.set_parent(v, components[v]);
+            }
+        });
+        parallel_for(num_vertexes, num_threads,
+                [&graph, &components, &lightest](std::size_t, std::size_t begin, std::size_t end) {
+            for (Vertex v = begin; v < end; v++) {
+                uint64_t best = std::numeric_limits<uint64_t>::max();
+                for (const Edge & edge : graph[v]) {
+                    if (components[edge.get_to()] != components[v]) {
+                        best = std::min(best, (uint64_t)edge.get_weight() << 32 | v);
+                    }
+                }
+                std::atomic<uint64_t> & component_best = lightest[components[v]];
+                uint64_t current = component_best.load(std::memory_order_relaxed);
+                while (best < current && !component_best.compare_exchange_weak(current, best)) {}
+            }
+        });
+
+        // The picked edges form a forest plus one cycle of equally light edges at most per tree, which merge skips.
+        roots.clear();
+        for (Vertex v = 0; v < num_vertexes; v++) {
+            if (components[v] == v && lightest[v].load(std::memory_order_relaxed) != no_edge) {
+                roots.push_back(v);
+            }
+        }
+        if (roots.empty()) {
+            return;
+        }
+        merged_from.assign(roots.size(), 0);
+        merged_to.assign(roots.size(), 0);
+        parallel_for(roots.size(), num_threads,
+                [&graph, &roots, &components, &lightest, &merged_from, &merged_to]
+                (std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; i++) {
+                uint64_t best = lightest[roots[i]].load(std::memory_order_relaxed);
+                auto weight = (DistType)(best >> 32);
+                Vertex from = best & 0xFFFFFFFFULL;
+                for (const Edge & edge : graph[from]) {
+                    if (edge.get_weight() == weight && components[edge.get_to()] != components[from]) {
+                        merged_from[i] = from;
+                        merged_to[i] = edge.get_to();
+                        break;
+                    }
+                }
+            }
+        }, 256);
+        for (std::size_t i = 0; i < roots.size(); i++) {
+            if (sets.merge(merged_from[i], merged_to[i])) {
+                result.total_weight += lightest[roots[i]].load(std::memory_order_relaxed) >> 32;
+                result.num_edges++;
+            }
+        }
+    }
+}
+
+inline MSTResult calc_mst_boruvka(const AdjList & graph, std::size_t num_threads, Timer & state) {
+    DisjointSets sets(graph.size());
+    MSTResult result;
+    state.resume_timing();
+    boruvka_rounds(graph, num_threads, sets, result);
+    state.pause_timing();
+    return result;
+}
+
+inline MSTResult calc_mst_prim(const AdjList & graph, std::size_t num_threads, Timer & state,
+                               std::size_t max_fragment_size = 1 << 16) {
+    const std::size_t num_vertexes = graph.size();
+    const CompactVertex no_fragment = no_parent;
+    std::unique_ptr<std::atomic<CompactVertex>[]> fragments(new std::atomic<CompactVertex>[num_vertexes]);
+    for (std::size_t v = 0; v < num_vertexes; v++) {
+        fragments[v].store(no_fragment, std::memory_order_relaxed);
+    }
+    std::vector<std::unique_ptr<SearchSpace>> spaces(num_threads);
+    std::vector<MSTResult> thread_results(num_threads);
+    state.resume_timing();
+    parallel_for(num_vertexes, num_threads,
+            [&graph, &fragments, &spaces, &thread_results, num_vertexes, max_fragment_size, no_fragment]
+            (std::size_t thread_id, std::size_t begin, std::size_t end) {
+        if (!spaces[thread_id]) {
+            spaces[thread_id].reset(new SearchSpace(num_vertexes, max_fragment_size));
+        }
+        SearchSpace & space = *spaces[thread_id];
+        MSTResult & result = thread_results[thread_id];
+        for (Vertex root = begin; root < end; root++) {
+            CompactVertex expected = no_fragment;
+            if (!fragments[root].compare_exchange_strong(expected, (CompactVertex)root)) {
+                continue;
+            }
+            space.clear();
+            space.relax(root, 0);
+            bool growing = true;
+            while (growing && !space.empty()) {
+                SearchSpace::Element * element = space.pop();
+                Vertex v = element->vertex;
+                if (v != root) {
+                    expected = no_fragment;
+                    if (!fragments[v].compare_exchange_strong(expected, (CompactVertex)root)) {
+                        break;
+                    }
+                    result.total_weight += element->get_dist_relaxed();
+                    result.num_edges++;
+                }
+                for (const Edge & edge : graph[v]) {
+                    Vertex to = edge.get_to();
+                    if (fragments[to].load(std::memory_order_relaxed) != root
+                            && !space.relax(to, edge.get_weight(), (CompactVertex)v)) {
+                        growing = false;
+                        break;
+                    }
+                }
+            }
+        }
+    }, 1 << 10);
+
+    DisjointSets sets(num_vertexes);
+    for (Vertex v = 0; v < num_vertexes; v++) {
+        sets.set_parent(v, fragments[v].load(std::memory_order_relaxed));
+    }
+    MSTResult result;
+    for (const MSTResult & thread_result : thread_results) {
+        result.total_weight += thread_result.total_weight;
+        result.num_edges += thread_result.num_edges;
+    }
+    boruvka_rounds(graph, num_threads, sets, result);
+    state.pause_timing();
+    return result;
+}
+
+#endif //MULTIQUEUE_MST_H
@@ -14,26 +14,31 @@
 
 #include "binary_heap.h"
 
-// Set DIST_PADDING and QUEUE_PADDING to either of padded, aligned, or not_padded.
-// If using padded or aligned, set PADDING or ALIGNMENT, respectively.
-
 const std::size_t dummy_iterations_before_exiting = 100;
 
-template<class T>
+// Sub-queue layouts. A Multiqueue is instantiated with one of them wrapped around its binary heap type,
+// see layouts.h for the layouts selectable at run time.
+
+template<class T, std::size_t padding_size = 128>
 struct padded {
+    using value_type = T;
     T first;
-    volatile char pad[PADDING]{};
-    explicit padded(std::size_t reserve_size) : first(my_d_ary_heap<>(reserve_size)) {}
+    volatile char pad[padding_size]{};
+    explicit padded(std::size_t reserve_size) : first(reserve_size) {}
 };
 
-template<class T>
-struct alignas(ALIGNMENT) aligned {
+template<class T, std::size_t alignment = 128>
+struct alignas(alignment) aligned {
+    using value_type = T;
     T first;
+    explicit aligned(std::size_t reserve_size) : first(reserve_size) {}
 };
 
 template<class T>
 struct not_padded {
+    using value_type = T;
     T first;
+    explicit not_padded(std::size_t reserve_size) : first(reserve_size) {}
 };
 
 inline uint64_t random_fnv1a(uint64_t & seed) {
@@ -47,32 +52,175 @@ inline uint64_t random_fnv1a(uint64_t & seed) {
     return hash;
 }
 
-class Multiqueue {
+// Adaptive mode: the number of active sub-queues changes at run time between 2 and num_threads * K. Each thread counts
+// its lock attempts and samples, the samples of two empty queues, and the locks it found taken or tops it found changed
+// (contention). Every adapt_window operations, a thread grows the active queues by a quarter on high contention and
+// shrinks them by a quarter on many empty samples, as at the start and the tail of a Dijkstra run.
+// Pushes and pops only pick active queues. A deactivated queue is drained into the active ones under both locks, and a
+// push which locked an inactive queue retries, so no element is left where pops don't look.
+const uint32_t adapt_window = 1024;
+const uint32_t grow_contention_divisor = 16;  // grow if more than 1/16 of the operations were contended
+const uint32_t shrink_empty_divisor = 4;  // shrink if more than 1/4 of the operations sampled empty queues
+const uint32_t shrink_contention_divisor = 64;  // and at most 1/64 of the operations were contended
+
+template<class WrappedQueue = padded<my_d_ary_heap<>>>
+class BasicMultiqueue {
+public:
+    using Element = typename WrappedQueue::value_type::element_type;
+    using dist_type = typename Element::dist_type;
 private:
-    std::vector<QUEUE_PADDING<my_d_ary_heap<>>> queues;
+    class AdaptiveStatistics {
+    public:
+        const void * owner = nullptr;
+        uint32_t operations = 0;
+        uint32_t empty_samples = 0;
+        uint32_t contended = 0;
+    };
+
+    std::vector<WrappedQueue> queues;
     const std::size_t num_queues;
+    const bool adaptive;
+    const std::size_t min_active_queues;
+    std::atomic<std::size_t> num_active_queues;
+    Spinlock resizing;
+    std::atomic<std::size_t> num_resizes{0};
+
+    AdaptiveStatistics & get_statistics() {
+        thread_local AdaptiveStatistics statistics;
+        if (statistics.owner != this) {
+            statistics = AdaptiveStatistics();
+            statistics.owner = this;
+        }
+        return statistics;
+    }
+    // In the adaptive mode, fewer queues may have to take all elements.
+    template<class Queue>
+    void push_growing(Queue & queue, Element * element) {
+        if (adaptive && queue.full()) {
+            queue.reserve(2 * queue.capacity() + 1);
+        }
+        queue.push(element);
+    }
+    template<class Queue>
+    void lock_counting(Queue & queue) {
+        if (!adaptive) {
+            queue.lock();
+            return;
+        }
+        AdaptiveStatistics & statistics = get_statistics();
+        statistics.operations++;
+        if (!queue.try_lock()) {
+            statistics.contended++;
+            queue.lock();
+        }
+    }
+    void adapt() {
+        AdaptiveStatistics & statistics = get_statistics();
+        if (statistics.operations < adapt_window) {
+            return;
+        }
+        uint32_t operations = statistics.operations;
+        bool grow = statistics.contended > operations / grow_contention_divisor;
+        bool shrink = statistics.empty_samples > operations / shrink_empty_divisor
+                      && statistics.contended <= operations / shrink_contention_divisor;
+        statistics.operations = statistics.empty_samples = statistics.contended = 0;
+        if ((!grow && !shrink) || !resizing.try_lock()) {
+            return;
+        }
+        std::size_t active = num_active_queues.load(std::memory_order_relaxed);
+        if (grow) {
+            resize(active + active / 4 + 1);
+        } else {
+            resize(active - std::max<std::size_t>(1, active / 4));
+        }
+        resizing.unlock();
+    }
+    // Call under the resizing lock.
+    void resize(std::size_t new_active) {
+        std::size_t active = num_active_queues.load(std::memory_order_relaxed);
+        new_active = std::max(min_active_queues, std::min(num_queues, new_active));
+        if (new_active == active) {
+            return;
+        }
+        num_active_queues.store(new_active, std::memory_order_relaxed);
+        for (std::size_t q_id = new_active; q_id < active; q_id++) {
+            drain(q_id);
+        }
+        num_resizes++;
+    }
+    // Moves the elements of an inactive queue to active ones. q_id changes under the locks of both queues, so a push
+    // holding either lock sees a consistent q_id, and a push holding neither retries on the new one.
+    void drain(std::size_t q_id) {
+        auto & source = queues[q_id].first;
+        source.lock();
+        while (!source.empty()) {
+            Element * element = source.top();
+            source.pop();
+            std::size_t target_id = gen_random_queue_index();
+            auto & target = queues[target_id].first;
+            target.lock();
+            push_growing(target, element);
+            element->set_q_id_relaxed((int)target_id);
+            target.unlock();
+        }
+        source.unlock();
+    }
+
 public:
-    Multiqueue(int num_threads, int size_multiple, std::size_t one_queue_reserve_size) :
-            num_queues(num_threads * size_multiple) {
+    BasicMultiqueue(int num_threads, int size_multiple, std::size_t one_queue_reserve_size, bool adaptive = false) :
+            num_queues(num_threads * size_multiple), adaptive(adaptive),
+            min_active_queues(adaptive ? std::min<std::size_t>(num_queues, 2) : num_queues),
+            num_active_queues(num_queues) {
         queues.reserve(num_queues);
         for (std::size_t i = 0; i < num_queues; i++) {
             queues.emplace_back(one_queue_reserve_size);
         }
     }
+    // A random active queue.
     std::size_t gen_random_queue_index() const {
         static std::atomic<size_t> num_threads_registered{0};
         thread_local uint64_t seed = 2758756369U + num_threads_registered++;
-        return random_fnv1a(seed) % num_queues;
+        return random_fnv1a(seed) % num_active_queues.load(std::memory_order_relaxed);
+    }
+    std::size_t get_num_active_queues() const {
+        return num_active_queues.load(std::memory_order_relaxed);
+    }
+    std::size_t get_num_resizes() const {
+        return num_resizes.load(std::memory_order_relaxed);
+    }
+    // Sets the number of active queues in the adaptive mode, within its bounds. Safe while other threads push and pop,
+    // but pops miss the elements being moved, so the calling thread should pop afterwards, as in the adaptive mode.
+    void set_num_active_queues(std::size_t new_active) {
+        resizing.lock();
+        resize(new_active);
+        resizing.unlock();
     }
 
-    void push_singlethreaded(QueueElement * element, int new_dist) {
+    void push_singlethreaded(Element * element, dist_type new_dist, CompactVertex parent = no_parent) {
         std::size_t q_id = gen_random_queue_index();
         element->set_dist_relaxed(new_dist);
-        queues[q_id].first.push(element);
+        element->set_parent_relaxed(parent);
+        push_growing(queues[q_id].first, element);
+        element->set_q_id_relaxed((int)q_id);
+    }
+    // Pops every element and passes it to f, while no other thread uses the queue.
+    template<class F>
+    void pop_all_singlethreaded(F f) {
+        for (auto & wrapped : queues) {
+            auto & queue = wrapped.first;
+            while (!queue.empty()) {
+                Element * element = queue.top();
+                queue.pop();
+                element->set_q_id_relaxed(-1);
+                f(element);
+            }
+        }
     }
 
     // element->dist should be > new_dist, otherwise nothing happens
-    void push(QueueElement * element, int new_dist) {
+    // parent is set together with dist under the queue lock, so that the final parent matches the final dist
+    // returns true if the element was added to a queue, false after a decrease_key or if nothing happened
+    bool push(Element * element, dist_type new_dist, CompactVertex parent = no_parent) {
         // we can change dist only once the corresponding binary heap is locked
         while (true) {
             int empty_q_id = -1;
@@ -83,7 +231,7 @@ public:
                 q_id = gen_random_queue_index();
             }
             auto & queue = queues[q_id].first;
-            queue.lock();
+            lock_counting(queue);
             // q_id could:
             // 0) was -1, we generated random id
             // 1) stay the same but dist might or might not change (push OR none)
@@ -92,30 +240,38 @@ public:
             if (element->get_q_id_relaxed() == q_id) { // 1 // If so under the queue's lock + mb, this is the real q_id.
                 if (new_dist < element->get_dist()) {
                     queue.decrease_key(element, new_dist);
+                    element->set_parent_relaxed(parent);
                 }
                 queue.unlock();
-                break;
+                return false;
             } else if (adding or element->get_q_id_relaxed() == empty_q_id) {
                 // 0, aka element->q_id was empty_q_id;
                 // OR 2, aka someone popped the element, but since we already locked this queue, push to it
                 // OR this thread didn't see that q_id was changed to -1,
                 //     but now it sees that someone popped from this queue under the queue lock's memory barrier.
+                if ((std::size_t)q_id >= num_active_queues.load(std::memory_order_relaxed)) {
+                    // The queue was deactivated, and it might have been drained already.
+                    queue.unlock();
+                    continue;
+                }
                 element->empty_q_id_lock();
-                if (element->get_q_id_relaxed() != empty_q_id) {
+                if (element->get_q_id_acquire() != empty_q_id) {
                     // Either someone pushed right before this thread, or this thread didn't see that it was pushed
                     // a long time ago, but now it sees the last q_id assigned under the empty lock's memory barrier.
                     element->empty_q_id_unlock();
                     queue.unlock();
                     continue;
                 }
-                if (new_dist < element->get_dist()) {
+                bool added = new_dist < element->get_dist();
+                if (added) {
                     element->set_dist_relaxed(new_dist);
-                    queue.push(element);
+                    element->set_parent_relaxed(parent);
+                    push_growing(queue, element);
                     element->set_q_id_relaxed(q_id);
                 }
                 element->empty_q_id_unlock();
                 queue.unlock();
-                break;
+                return added;
             } else {  // 3
                 queue.unlock();
                 continue;
@@ -123,20 +279,23 @@ public:
         }
     }
 
-    QueueElement * pop() {
+    Element * pop() {
         if (num_queues == 1) {
             auto & q = queues.front().first;
             q.lock();
             if (q.empty()) {
                 q.unlock();
-                return const_cast<QueueElement *>(&empty_element);
+                return const_cast<Element *>(&Element::empty_element);
             }
-            QueueElement * e = q.top();
-            e->set_q_id_relaxed(-1);
+            Element * e = q.top();
             q.pop();
+            e->set_q_id_release(-1);
             q.unlock();
             return e;
         }
+        if (adaptive) {
+            adapt();
+        }
 
         while (true) {
             bool seen_progress_by_other_threads = false;
@@ -150,38 +309,63 @@ public:
                 auto &q1 = queues[std::min(i, j)].first;
                 auto &q2 = queues[std::max(i, j)].first;
 
-                QueueElement *e1 = q1.top_relaxed();
-                QueueElement *e2 = q2.top_relaxed();
+                Element *e1 = q1.top_relaxed();
+                Element *e2 = q2.top_relaxed();
 
-                if (e1 == &empty_element && e2 == &empty_element) {
+                if (e1 == &Element::empty_element && e2 == &Element::empty_element) {
+                    if (adaptive) {
+                        AdaptiveStatistics & statistics = get_statistics();
+                        statistics.operations++;
+                        statistics.empty_samples++;
+                        adapt();
+                    }
                     continue;
                 }
 
                 auto * q_ptr = &q1;
-                QueueElement *e = e1;
+                Element *e = e1;
                 // reversed comparator because std::priority_queue is a max queue
-                if (e1 == &empty_element || (e2 != &empty_element && *e1 < *e2)) {
+                if (e1 == &Element::empty_element || (e2 != &Element::empty_element && *e1 < *e2)) {
                     q_ptr = &q2;
                     e = e2;
                 }
                 auto & q = *q_ptr;
-                q.lock();
+                lock_counting(q);
                 if (q.top() != e) {
                     q.unlock();
+                    if (adaptive) {
+                        get_statistics().contended++;
+                    }
                     seen_progress_by_other_threads = true;
                     break;
                 }
                 q.pop();
-                e->set_q_id_relaxed(-1);
+                e->set_q_id_release(-1);
                 q.unlock();
                 return e;
             }
             if (seen_progress_by_other_threads) {
                 continue;
             }
-            return const_cast<QueueElement *>(&empty_element);
+            return const_cast<Element *>(&Element::empty_element);
         }
     }
 };
 
+using Multiqueue = BasicMultiqueue<>;
+
+// A Multiqueue in the adaptive mode, with num_threads * K sub-queues at most.
+template<class WrappedQueue = padded<my_d_ary_heap<>>>
+class BasicAdaptiveMultiqueue : public BasicMultiqueue<WrappedQueue> {
+public:
+    BasicAdaptiveMultiqueue(int num_threads, int size_multiple, std::size_t one_queue_reserve_size)
+            : BasicMultiqueue<WrappedQueue>(num_threads, size_multiple, one_queue_reserve_size, true) {}
+};
+
+using AdaptiveMultiqueue = BasicAdaptiveMultiqueue<>;
+
+// The default layouts with another distance type, e.g. uint64_t for graphs whose distances overflow int.
+template<class Dist>
+using DistMultiqueue = BasicMultiqueue<padded<my_d_ary_heap<8, BasicQueueElement<element_padded<128>, Dist>>>>;
+
 #endif //MULTIQUEUE_MULTIQUEUE_H
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef MULTIQUEUE_SEARCH_SPACE_H
+#define MULTIQUEUE_SEARCH_SPACE_H
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "binary_heap.h"
+
+/* Dijkstra state on my_d_ary_heap for searches which touch few vertices: instead of clearing arrays of size
+ * num_vertexes, only the touched vertices are reset before the next search. The state of the touched vertices starts
+ * at initial_touched and doubles up to max_touched, so a search space for all vertices doesn't take memory for all
+ * of them upfront. */
+class SearchSpace {
+public:
+    using Element = BasicQueueElement<element_not_padded>;
+private:
+    static constexpr CompactVertex untouched = no_parent;
+    std::vector<CompactVertex> slots;
+    std::vector<Element> elements;  // the heap points to the elements, so it's rebuilt when they grow
+    std::vector<char> settled;
+    std::size_t num_touched = 0;
+    std::size_t max_touched;
+    my_d_ary_heap<4, Element> heap;
+
+    // Reallocates the elements, and pushes the ones which were in the heap to a new heap.
+    void grow() {
+        std::size_t capacity = std::min(max_touched, std::max<std::size_t>(2 * elements.size(), 1));
+        elements.reserve(capacity);
+        while (elements.size() < capacity) {
+            elements.emplace_back();
+        }
+        settled.resize(capacity);
+        heap = my_d_ary_heap<4, Element>(capacity);
+        heap.clear();
+        for (std::size_t slot = 0; slot < num_touched; slot++) {
+            if (!settled[slot]) {
+                heap.push(&elements[slot]);
+            }
+        }
+    }
+public:
+    SearchSpace(std::size_t num_vertexes, std::size_t max_touched, std::size_t initial_touched)
+            : slots(num_vertexes, untouched), elements(std::min(initial_touched, max_touched)),
+              settled(elements.size()), max_touched(max_touched), heap(elements.size()) {}
+    SearchSpace(std::size_t num_vertexes, std::size_t max_touched)
+            : SearchSpace(num_vertexes, max_touched, max_touched) {}
+    void clear() {
+        for (std::size_t i = 0; i < num_touched; i++) {
+            slots[elements[i].vertex] = untouched;
+        }
+        num_touched = 0;
+        heap.clear();
+    }
+    // Returns false if max_touched vertices are already touched and v isn't one of them.
+    // The parent is kept along with the distance.
+    bool relax(Vertex v, DistType dist, CompactVertex parent = no_parent) {
+        CompactVertex slot = slots[v];
+        if (slot == untouched) {
+            if (num_touched == max_touched) {
+                return false;
+            }
+            if (num_touched == elements.size()) {
+                grow();
+            }
+            slot = (CompactVertex)num_touched++;
+            Element & element = elements[slot];
+            element.vertex = v;
+            element.set_dist_relaxed(dist);
+            element.set_parent_relaxed(parent);
+            settled[slot] = false;
+            slots[v] = slot;
+            heap.push(&element);
+        } else if (!settled[slot] && dist < elements[slot].get_dist_relaxed()) {
+            heap.decrease_key(&elements[slot], dist);
+            elements[slot].set_parent_relaxed(parent);
+        }
+        return true;
+    }
+    bool empty() const {
+        return heap.empty();
+    }
+    DistType get_min_dist() const {
+        return heap.top()->get_dist_relaxed();
+    }
+    // Settles and returns the vertex with the minimal distance. The element is valid until the next relax, which may
+    // grow the elements.
+    Element * pop() {
+        Element * element = heap.top();
+        heap.pop();
+        settled[slots[element->vertex]] = true;
+        return element;
+    }
+    // The length of the shortest path found so far, or infinity.
+    DistType get_dist(Vertex v) const {
+        CompactVertex slot = slots[v];
+        return slot == untouched ? std::numeric_limits<DistType>::max() : elements[slot].get_dist_relaxed();
+    }
+};
+
+#endif //MULTIQUEUE_SEARCH_SPACE_H
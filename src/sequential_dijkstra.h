@@ -0,0 +1,310 @@
+#ifndef MULTIQUEUE_SEQUENTIAL_DIJKSTRA_H
+#define MULTIQUEUE_SEQUENTIAL_DIJKSTRA_H
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "dijkstra.h"
+
+// Tuned sequential Dijkstras, the baselines the parallel engines should beat. calc_dijkstra_sequential uses
+// std::priority_queue with lazy deletion on the AdjList; these run on a CompactGraph instead:
+// - calc_dijkstra_dary: a 4-ary heap of (distance, vertex) pairs with decrease_key, so each vertex is in it once;
+// - calc_dijkstra_radix: a radix heap (Ahuja et al., 1990), which takes the monotone integer keys of Dijkstra into 33
+//   buckets by the highest bit in which they differ from the last minimum, with lazy deletion;
+// - calc_dijkstra_dial: Dial's buckets, one per distance modulo max_weight + 1, for small integer weights.
+// All need non-negative weights.
+
+// The arcs of all vertices in one array, with 32-bit heads and weights: 8 bytes per arc and no pointer per vertex.
+class CompactGraph {
+public:
+    class Arc {
+    public:
+        CompactVertex to;
+        DistType weight;
+    };
+private:
+    std::vector<uint64_t> offsets;
+    std::vector<Arc> arcs;
+    DistType max_weight = 0;
+public:
+    CompactGraph() : offsets(1, 0) {}
+    // Throws std::invalid_argument on negative weights or too many vertices for 32-bit ids.
+    explicit CompactGraph(const AdjList & graph) : offsets(graph.size() + 1, 0) {
+        if (graph.size() >= no_parent) {
+            throw std::invalid_argument("too many vertices for 32-bit ids: " + std::to_string(graph.size()));
+        }
+        for (std::size_t v = 0; v < graph.size(); v++) {
+            offsets[v + 1] = offsets[v] + graph[v].size();
+        }
+        arcs.reserve(offsets.back());
+        for (const auto & edges : graph) {
+            for (const Edge & edge : edges) {
+                if (edge.get_weight() < 0) {
+                    throw std::invalid_argument("negative weight: " + std::to_string(edge.get_weight()));
+                }
+                arcs.push_back({(CompactVertex)edge.get_to(), edge.get_weight()});
+                max_weight = std::max(max_weight, edge.get_weight());
+            }
+        }
+    }
+    std::size_t size() const {
+        return offsets.size() - 1;
+    }
+    std::size_t get_num_arcs() const {
+        return arcs.size();
+    }
+    DistType get_max_weight() const {
+        return max_weight;
+    }
+    const Arc * begin(Vertex v) const {
+        return arcs.data() + offsets[v];
+    }
+    const Arc * end(Vertex v) const {
+        return arcs.data() + offsets[v + 1];
+    }
+};
+
+// A d-ary min-heap of vertices which keeps the position of each vertex for decrease_key.
+template<std::size_t D = 4>
+class IndexedDAryHeap {
+public:
+    class Entry {
+    public:
+        DistType key;
+        CompactVertex vertex;
+    };
+private:
+    static constexpr CompactVertex absent = no_parent;
+    std::vector<Entry> entries;
+    std::vector<CompactVertex> positions;
+
+    void place(std::size_t i, const Entry & entry) {
+        entries[i] = entry;
+        positions[entry.vertex] = (CompactVertex)i;
+    }
+    void sift_up(std::size_t i, const Entry & entry) {
+        while (i > 0) {
+            std::size_t parent = (i - 1) / D;
+            if (entries[parent].key <= entry.key) {
+                break;
+            }
+            place(i, entries[parent]);
+            i = parent;
+        }
+        place(i, entry);
+    }
+    void sift_down(std::size_t i, const Entry & entry) {
+        const std::size_t size = entries.size();
+        while (true) {
+            std::size_t first = i * D + 1;
+            if (first >= size) {
+                break;
+            }
+            std::size_t best = first;
+            std::size_t last = std::min(first + D, size);
+            for (std::size_t child = first + 1; child < last; child++) {
+                if (entries[child].key < entries[best].key) {
+                    best = child;
+                }
+            }
+            if (entries[best].key >= entry.key) {
+                break;
+            }
+            place(i, entries[best]);
+            i = best;
+        }
+        place(i, entry);
+    }
+public:
+    explicit IndexedDAryHeap(std::size_t num_vertexes) : positions(num_vertexes, absent) {}
+    bool empty() const {
+        return entries.empty();
+    }
+    // Inserts v, or lowers its key if it's in the heap already. A popped vertex must not be pushed again.
+    void push_or_decrease(Vertex v, DistType key) {
+        if (positions[v] == absent) {
+            entries.emplace_back();
+            sift_up(entries.size() - 1, {key, (CompactVertex)v});
+        } else {
+            sift_up(positions[v], {key, (CompactVertex)v});
+        }
+    }
+    Entry pop() {
+        Entry top = entries.front();
+        positions[top.vertex] = absent;
+        Entry last = entries.back();
+        entries.pop_back();
+        if (!entries.empty()) {
+            sift_down(0, last);
+        }
+        return top;
+    }
+};
+
+// A monotone priority queue for unsigned 32-bit keys: a pushed key must not be less than the last popped one.
+class RadixHeap {
+public:
+    class Entry {
+    public:
+        uint32_t key;
+        CompactVertex vertex;
+    };
+private:
+    std::array<std::vector<Entry>, 33> buckets;
+    uint32_t last = 0;
+    std::size_t size = 0;
+
+    static std::size_t bucket_of(uint32_t key, uint32_t last) {
+        return key == last ? 0 : 32 - __builtin_clz(key ^ last);
+    }
+public:
+    bool empty() const {
+        return size == 0;
+    }
+    void push(uint32_t key, Vertex v) {
+        buckets[bucket_of(key, last)].push_back({key, (CompactVertex)v});
+        size++;
+    }
+    // The elements of the first non-empty bucket go to lower buckets relative to their minimum, each element moves
+    // to lower buckets only, so a pop takes O(log C) amortized time.
+    Entry pop() {
+        if (buckets[0].empty()) {
+            std::size_t i = 1;
+            while (buckets[i].empty()) {
+                i++;
+            }
+            last = std::min_element(buckets[i].begin(), buckets[i].end(), [](const Entry & a, const Entry & b) {
+                return a.key < b.key;
+            })->key;
+            for (const Entry & entry : buckets[i]) {
+                buckets[bucket_of(entry.key, last)].push_back(entry);
+            }
+            buckets[i].clear();
+        }
+        Entry entry = buckets[0].back();
+        buckets[0].pop_back();
+        size--;
+        return entry;
+    }
+};
+
+// Larger weights take too much memory for the buckets.
+const DistType dial_max_weight = 1 << 20;
+
+// Common state of the sequential engines: the distances, and the parents if they are tracked.
+class SequentialDijkstraState {
+public:
+    DistVector dists;
+    ParentVector parents;
+    const bool track_parents;
+    SequentialDijkstraState(std::size_t num_vertexes, bool track_parents)
+            : dists(num_vertexes, DistTraits<DistType>::infinity()),
+              parents(track_parents ? num_vertexes : 0, no_parent), track_parents(track_parents) {}
+    // Returns true if the distance of to went down.
+    bool relax(Vertex from, DistType from_dist, const CompactGraph::Arc & arc) {
+        DistType new_dist = DistTraits<DistType>::add(from_dist, arc.weight);
+        if (new_dist >= dists[arc.to]) {
+            return false;
+        }
+        dists[arc.to] = new_dist;
+        if (track_parents) {
+            parents[arc.to] = (CompactVertex)from;
+        }
+        return true;
+    }
+    DistsAndStatistics get_result() {
+        return DistsAndStatistics(std::move(dists), std::move(parents));
+    }
+};
+
+inline DistsAndStatistics calc_dijkstra_dary(const CompactGraph & graph, Timer & state, bool track_parents = false) {
+    const Vertex start_vertex = 0;
+    SequentialDijkstraState dijkstra(graph.size(), track_parents);
+    if (graph.size() == 0) {
+        return dijkstra.get_result();
+    }
+    IndexedDAryHeap<4> heap(graph.size());
+    state.resume_timing();
+    dijkstra.dists[start_vertex] = 0;
+    heap.push_or_decrease(start_vertex, 0);
+    while (!heap.empty()) {
+        IndexedDAryHeap<4>::Entry top = heap.pop();
+        for (const CompactGraph::Arc * arc = graph.begin(top.vertex); arc != graph.end(top.vertex); arc++) {
+            if (dijkstra.relax(top.vertex, top.key, *arc)) {
+                heap.push_or_decrease(arc->to, dijkstra.dists[arc->to]);
+            }
+        }
+    }
+    state.pause_timing();
+    return dijkstra.get_result();
+}
+
+inline DistsAndStatistics calc_dijkstra_radix(const CompactGraph & graph, Timer & state, bool track_parents = false) {
+    const Vertex start_vertex = 0;
+    SequentialDijkstraState dijkstra(graph.size(), track_parents);
+    if (graph.size() == 0) {
+        return dijkstra.get_result();
+    }
+    RadixHeap heap;
+    state.resume_timing();
+    dijkstra.dists[start_vertex] = 0;
+    heap.push(0, start_vertex);
+    while (!heap.empty()) {
+        RadixHeap::Entry top = heap.pop();
+        if ((DistType)top.key != dijkstra.dists[top.vertex]) {
+            continue;  // the vertex was pushed again with a smaller distance
+        }
+        for (const CompactGraph::Arc * arc = graph.begin(top.vertex); arc != graph.end(top.vertex); arc++) {
+            if (dijkstra.relax(top.vertex, (DistType)top.key, *arc)) {
+                heap.push((uint32_t)dijkstra.dists[arc->to], arc->to);
+            }
+        }
+    }
+    state.pause_timing();
+    return dijkstra.get_result();
+}
+
+// Throws std::invalid_argument if the weights exceed dial_max_weight.
+inline DistsAndStatistics calc_dijkstra_dial(const CompactGraph & graph, Timer & state, bool track_parents = false) {
+    if (graph.get_max_weight() > dial_max_weight) {
+        throw std::invalid_argument("Dial's buckets need weights up to " + std::to_string(dial_max_weight) + ", got "
+                                    + std::to_string(graph.get_max_weight()));
+    }
+    const Vertex start_vertex = 0;
+    SequentialDijkstraState dijkstra(graph.size(), track_parents);
+    if (graph.size() == 0) {
+        return dijkstra.get_result();
+    }
+    // All pushed distances lie within max_weight of the current one, so they map to distinct buckets.
+    const std::size_t num_buckets = (std::size_t)graph.get_max_weight() + 1;
+    std::vector<std::vector<CompactVertex>> buckets(num_buckets);
+    state.resume_timing();
+    dijkstra.dists[start_vertex] = 0;
+    buckets[0].push_back(start_vertex);
+    std::size_t num_pending = 1;
+    for (DistType current = 0; num_pending > 0; current++) {
+        std::vector<CompactVertex> & bucket = buckets[(std::size_t)current % num_buckets];
+        while (!bucket.empty()) {
+            Vertex v = bucket.back();
+            bucket.pop_back();
+            num_pending--;
+            if (dijkstra.dists[v] != current) {
+                continue;  // the vertex was pushed again with a smaller distance
+            }
+            for (const CompactGraph::Arc * arc = graph.begin(v); arc != graph.end(v); arc++) {
+                if (dijkstra.relax(v, current, *arc)) {
+                    buckets[(std::size_t)dijkstra.dists[arc->to] % num_buckets].push_back(arc->to);
+                    num_pending++;
+                }
+            }
+        }
+    }
+    state.pause_timing();
+    return dijkstra.get_result();
+}
+
+#endif //MULTIQUEUE_SEQUENTIAL_DIJKSTRA_H
@@ -0,0 +1,228 @@
+#ifndef MULTIQUEUE_STEALING_QUEUE_H
+#define MULTIQUEUE_STEALING_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+#include "binary_heap.h"
+#include "multiqueue.h"
+
+// A work-stealing alternative to the Multiqueue with the same interface, for dijkstra_thread_routine.
+//
+// Each thread owns size_multiple heaps. It adds new elements to its own heaps and pops the best of their tops, so in
+// the common case no other thread touches its heaps and their locks stay in its cache. When its heaps are empty, it
+// steals the better top of two random heaps, as a Multiqueue pop does. Every lag_check_interval pops it also peeks at
+// two random heaps and steals if their top is better than its own by more than the lag threshold, so that a thread
+// doesn't settle vertices far behind the global minimum, which would be relaxed again later (wasted work).
+// The lag threshold is infinite by default, i.e. threads steal only when they run out of work.
+//
+// A decrease_key still happens in the heap which holds the element, whoever owns it, with the Multiqueue's q_id
+// protocol. A thread adds only to its own heaps: if the element was popped while the thread locked another heap, it
+// retries with a heap of its own. Each thread pops its own heaps until they are empty, so no element is left behind
+// when threads exit.
+const uint32_t lag_check_interval = 16;
+
+template<class WrappedQueue = padded<my_d_ary_heap<>>>
+class BasicStealingQueue {
+public:
+    using Element = typename WrappedQueue::value_type::element_type;
+    using dist_type = typename Element::dist_type;
+private:
+    class LocalState {
+    public:
+        const void * owner = nullptr;
+        std::size_t first_queue = 0;
+        uint64_t seed = 0;
+        uint32_t pops = 0;
+    };
+
+    std::vector<WrappedQueue> queues;
+    const std::size_t num_threads;
+    const std::size_t size_multiple;
+    dist_type lag_threshold = DistTraits<dist_type>::infinity();
+    std::atomic<std::size_t> num_threads_registered{0};
+    std::atomic<std::size_t> num_steals{0};
+
+    // The heaps of a thread are assigned on its first operation, in the order of the threads' first operations.
+    LocalState & get_local() {
+        thread_local LocalState local;
+        if (local.owner != this) {
+            std::size_t thread_index = num_threads_registered++;
+            local.owner = this;
+            local.first_queue = thread_index % num_threads * size_multiple;
+            local.seed = 2758756369U + thread_index;
+            local.pops = 0;
+        }
+        return local;
+    }
+    // Local heaps may have to take all elements of a run.
+    template<class Queue>
+    static void push_growing(Queue & queue, Element * element) {
+        if (queue.full()) {
+            queue.reserve(2 * queue.capacity() + 1);
+        }
+        queue.push(element);
+    }
+    static bool is_empty(const Element * element) {
+        return element == &Element::empty_element;
+    }
+    // The best of the tops of the given heaps, reads them without locking.
+    void best_top(std::size_t i, std::size_t j, std::size_t & best_id, Element *& best) const {
+        Element * e1 = queues[i].first.top_relaxed();
+        Element * e2 = queues[j].first.top_relaxed();
+        best_id = i;
+        best = e1;
+        // reversed comparator because std::priority_queue is a max queue
+        if (is_empty(e1) || (!is_empty(e2) && *e1 < *e2)) {
+            best_id = j;
+            best = e2;
+        }
+    }
+    void best_own_top(LocalState & local, std::size_t & best_id, Element *& best) const {
+        best_id = local.first_queue;
+        best = queues[best_id].first.top_relaxed();
+        for (std::size_t i = 1; i < size_multiple; i++) {
+            std::size_t next_id;
+            Element * next;
+            best_top(best_id, local.first_queue + i, next_id, next);
+            best_id = next_id;
+            best = next;
+        }
+    }
+    void random_victims_top(LocalState & local, std::size_t & best_id, Element *& best) const {
+        std::size_t num_queues = queues.size();
+        std::size_t i = random_fnv1a(local.seed) % num_queues;
+        std::size_t j = i;
+        while (num_queues > 1 && i == j) {
+            j = random_fnv1a(local.seed) % num_queues;
+        }
+        best_top(i, j, best_id, best);
+    }
+
+public:
+    BasicStealingQueue(int num_threads, int size_multiple, std::size_t one_queue_reserve_size)
+            : num_threads(std::max(num_threads, 1)), size_multiple(std::max(size_multiple, 1)) {
+        std::size_t num_queues = this->num_threads * this->size_multiple;
+        queues.reserve(num_queues);
+        for (std::size_t i = 0; i < num_queues; i++) {
+            queues.emplace_back(one_queue_reserve_size);
+        }
+    }
+    // Set before the threads start.
+    void set_lag_threshold(dist_type new_lag_threshold) {
+        lag_threshold = new_lag_threshold;
+    }
+    dist_type get_lag_threshold() const {
+        return lag_threshold;
+    }
+    // Pops of elements from the heaps of other threads.
+    std::size_t get_num_steals() const {
+        return num_steals.load(std::memory_order_relaxed);
+    }
+
+    // Into the first heap without registering the calling thread, so the seed goes to the thread which comes first.
+    void push_singlethreaded(Element * element, dist_type new_dist, CompactVertex parent = no_parent) {
+        element->set_dist_relaxed(new_dist);
+        element->set_parent_relaxed(parent);
+        push_growing(queues.front().first, element);
+        element->set_q_id_relaxed(0);
+    }
+
+    // The q_id protocol of BasicMultiqueue::push, except that new elements go to the own heaps of the thread.
+    // Returns true if the element was added, false if it was already in a heap.
+    bool push(Element * element, dist_type new_dist, CompactVertex parent = no_parent) {
+        while (true) {
+            int empty_q_id = -1;
+            int q_id = element->get_q_id_relaxed();
+            bool adding = false;
+            if (q_id == empty_q_id) {
+                adding = true;
+                LocalState & local = get_local();
+                q_id = (int)(local.first_queue + random_fnv1a(local.seed) % size_multiple);
+            }
+            auto & queue = queues[q_id].first;
+            queue.lock();
+            if (element->get_q_id_relaxed() == q_id) {
+                if (new_dist < element->get_dist()) {
+                    queue.decrease_key(element, new_dist);
+                    element->set_parent_relaxed(parent);
+                }
+                queue.unlock();
+                return false;
+            } else if (adding) {
+                element->empty_q_id_lock();
+                if (element->get_q_id_acquire() != empty_q_id) {
+                    element->empty_q_id_unlock();
+                    queue.unlock();
+                    continue;
+                }
+                bool added = new_dist < element->get_dist();
+                if (added) {
+                    element->set_dist_relaxed(new_dist);
+                    element->set_parent_relaxed(parent);
+                    push_growing(queue, element);
+                    element->set_q_id_relaxed(q_id);
+                }
+                element->empty_q_id_unlock();
+                queue.unlock();
+                return added;
+            } else {
+                // Moved to another heap, or popped from this one, which may belong to another thread: retry, adding
+                // to an own heap if it was popped.
+                queue.unlock();
+                continue;
+            }
+        }
+    }
+
+    Element * pop() {
+        LocalState & local = get_local();
+        while (true) {
+            bool seen_progress_by_other_threads = false;
+            for (std::size_t dummy_i = 0; dummy_i < dummy_iterations_before_exiting; dummy_i++) {
+                std::size_t q_id;
+                Element * e;
+                best_own_top(local, q_id, e);
+                bool check_lag = lag_threshold != DistTraits<dist_type>::infinity()
+                                 && ++local.pops % lag_check_interval == 0;
+                if (is_empty(e) || check_lag) {
+                    std::size_t victim_id;
+                    Element * victim;
+                    random_victims_top(local, victim_id, victim);
+                    if (is_empty(e) || (!is_empty(victim) && DistTraits<dist_type>::add(
+                            victim->get_dist_relaxed(), lag_threshold) < e->get_dist_relaxed())) {
+                        q_id = victim_id;
+                        e = victim;
+                    }
+                }
+                if (is_empty(e)) {
+                    continue;
+                }
+                auto & q = queues[q_id].first;
+                q.lock();
+                if (q.top() != e) {
+                    q.unlock();
+                    seen_progress_by_other_threads = true;
+                    break;
+                }
+                q.pop();
+                e->set_q_id_release(-1);
+                q.unlock();
+                if (q_id < local.first_queue || q_id >= local.first_queue + size_multiple) {
+                    num_steals.fetch_add(1, std::memory_order_relaxed);
+                }
+                return e;
+            }
+            if (seen_progress_by_other_threads) {
+                continue;
+            }
+            return const_cast<Element *>(&Element::empty_element);
+        }
+    }
+};
+
+using StealingQueue = BasicStealingQueue<>;
+
+#endif //MULTIQUEUE_STEALING_QUEUE_H
@@ -0,0 +1,353 @@
+#ifndef MULTIQUEUE_THROUGHPUT_H
+#define MULTIQUEUE_THROUGHPUT_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/barrier.hpp>
+
+#include "multiqueue.h"
+#include "utils.h"
+
+// Throughput (mops) benchmark of a Multiqueue under synthetic workloads.
+
+enum class KeyDistribution {
+    uniform,     // uniform keys in [0, max_key]
+    monotonic,   // last popped key + uniform in [1, 100], the hold model
+    ascending,   // each new key is bigger than all previous keys
+    descending,  // each new key is smaller than all previous keys
+    dijkstra     // last popped key + exponentially distributed edge weight, as in Dijkstra on road graphs
+};
+
+class Workload {
+public:
+    Workload(std::string name, KeyDistribution key_distribution, double push_fraction, std::size_t prefill,
+             std::size_t num_producers = 0)
+            : name(std::move(name)), key_distribution(key_distribution), push_fraction(push_fraction),
+              prefill(prefill), num_producers(num_producers) {}
+    std::string name;
+    KeyDistribution key_distribution;
+    // Fraction of pushes among the operations of a thread which both pushes and pops.
+    double push_fraction;
+    std::size_t prefill;
+    // If non-zero, that many threads only push and the others only pop, push_fraction is ignored.
+    std::size_t num_producers;
+    std::chrono::milliseconds duration{1000};
+    // Elements owned by each thread for pushing, in addition to the elements popped by it.
+    std::size_t elements_per_thread = 1 << 18;
+};
+
+inline std::vector<Workload> default_workloads() {
+    const auto prefill = (std::size_t)1e6;
+    return {
+            Workload("uniform", KeyDistribution::uniform, 0.5, prefill),
+            Workload("uniform_push75", KeyDistribution::uniform, 0.75, prefill),
+            Workload("uniform_push25", KeyDistribution::uniform, 0.25, prefill),
+            Workload("uniform_prefill1000", KeyDistribution::uniform, 0.5, 1000),
+            Workload("monotonic", KeyDistribution::monotonic, 0.5, prefill),
+            Workload("ascending", KeyDistribution::ascending, 0.5, prefill),
+            Workload("descending", KeyDistribution::descending, 0.5, prefill),
+            Workload("dijkstra", KeyDistribution::dijkstra, 0.5, prefill),
+            Workload("producer_consumer", KeyDistribution::uniform, 0.5, prefill, 1),
+    };
+}
+
+inline KeyDistribution parse_key_distribution(const std::string & name) {
+    const std::pair<const char *, KeyDistribution> names[] = {
+            {"uniform", KeyDistribution::uniform}, {"monotonic", KeyDistribution::monotonic},
+            {"ascending", KeyDistribution::ascending}, {"descending", KeyDistribution::descending},
+            {"dijkstra", KeyDistribution::dijkstra}};
+    for (const auto & entry : names) {
+        if (name == entry.first) {
+            return entry.second;
+        }
+    }
+    throw std::invalid_argument("unknown key distribution: " + name);
+}
+
+// A workload from keys:push_fraction:prefill[:duration_ms[:num_producers]], e.g. uniform:0.75:1000000 or
+// dijkstra:0.5:1000:2000:1, named by the spec. Throws std::invalid_argument on a malformed spec.
+inline Workload parse_workload(const std::string & spec) {
+    std::vector<std::string> parts;
+    std::size_t begin = 0;
+    while (true) {
+        std::size_t end = spec.find(':', begin);
+        parts.push_back(spec.substr(begin, end - begin));
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    if (parts.size() < 3 || parts.size() > 5) {
+        throw std::invalid_argument("expected keys:push_fraction:prefill[:duration_ms[:num_producers]], got " + spec);
+    }
+    auto to_number = [&spec](const std::string & part) {
+        std::size_t parsed = 0;
+        double number = 0;
+        try {
+            number = std::stod(part, &parsed);
+        } catch (const std::logic_error &) {
+            parsed = 0;
+        }
+        if (parsed == 0 || parsed != part.size() || number < 0) {
+            throw std::invalid_argument("not a non-negative number: " + part + " in " + spec);
+        }
+        return number;
+    };
+    double push_fraction = to_number(parts[1]);
+    if (push_fraction > 1) {
+        throw std::invalid_argument("push fraction above 1 in " + spec);
+    }
+    Workload workload(spec, parse_key_distribution(parts[0]), push_fraction, (std::size_t)to_number(parts[2]));
+    if (parts.size() > 3) {
+        workload.duration = std::chrono::milliseconds((int64_t)to_number(parts[3]));
+        if (workload.duration.count() == 0) {
+            throw std::invalid_argument("zero duration in " + spec);
+        }
+    }
+    if (parts.size() > 4) {
+        workload.num_producers = (std::size_t)to_number(parts[4]);
+    }
+    return workload;
+}
+
+// One workload spec per line, empty lines and lines starting with # are skipped.
+inline std::vector<Workload> read_workloads(const std::string & filename) {
+    std::ifstream input(filename);
+    if (!input) {
+        throw std::invalid_argument("can't open workloads file " + filename);
+    }
+    std::vector<Workload> workloads;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (!line.empty() && line[0] != '#') {
+            workloads.push_back(parse_workload(line));
+        }
+    }
+    return workloads;
+}
+
+class ThroughputResult {
+public:
+    std::vector<uint64_t> ops_per_thread;
+    std::vector<double> seconds_per_thread;
+    uint64_t empty_pops = 0;
+    // Pushes skipped because all elements of a thread were in the queue.
+    uint64_t stalls = 0;
+    uint64_t get_total_ops() const {
+        return std::accumulate(ops_per_thread.begin(), ops_per_thread.end(), 0ULL);
+    }
+    double get_seconds() const {
+        return seconds_per_thread.empty() ? 0 : *std::max_element(seconds_per_thread.begin(),
+                                                                   seconds_per_thread.end());
+    }
+    // Sum of per-thread rates, so a thread which stopped early doesn't dilute the others.
+    double get_mops() const {
+        double mops = 0;
+        for (std::size_t i = 0; i < ops_per_thread.size(); i++) {
+            if (seconds_per_thread[i] > 0) {
+                mops += ops_per_thread[i] / seconds_per_thread[i] / 1e6;
+            }
+        }
+        return mops;
+    }
+    double get_mean_ops_per_thread() const {
+        return ops_per_thread.empty() ? 0 : (double)get_total_ops() / ops_per_thread.size();
+    }
+    double get_stddev_ops_per_thread() const {
+        if (ops_per_thread.empty()) {
+            return 0;
+        }
+        double mean = get_mean_ops_per_thread();
+        double sum = 0;
+        for (uint64_t ops : ops_per_thread) {
+            sum += (ops - mean) * (ops - mean);
+        }
+        return std::sqrt(sum / ops_per_thread.size());
+    }
+    // 0 if no thread made an operation, e.g. when all consumers found the queue empty.
+    double get_cv_ops_per_thread() const {
+        double mean = get_mean_ops_per_thread();
+        return mean > 0 ? get_stddev_ops_per_thread() / mean : 0;
+    }
+};
+
+const DistType throughput_max_key = (DistType)1e9;
+
+class KeyGenerator {
+private:
+    KeyDistribution key_distribution;
+    uint64_t seed;
+    DistType counter = 0;
+    DistType step;
+    std::vector<DistType> weights;
+public:
+    // Keys generated by different threads (and by the prefill) don't repeat for ascending and descending.
+    KeyGenerator(KeyDistribution key_distribution, uint64_t seed, DistType first_counter, DistType step)
+            : key_distribution(key_distribution), seed(seed), counter(first_counter), step(step) {
+        if (key_distribution == KeyDistribution::dijkstra) {
+            std::mt19937_64 generator(seed);
+            std::exponential_distribution<double> distribution(1.0 / 1000);
+            weights.resize(1 << 12);
+            for (DistType & weight : weights) {
+                weight = 1 + (DistType)std::min(distribution(generator), 1e6);
+            }
+        }
+    }
+    DistType next(DistType last_popped) {
+        uint64_t r = random_fnv1a(seed) >> 16;
+        DistType key;
+        switch (key_distribution) {
+            case KeyDistribution::uniform:
+                return (DistType)(r % (throughput_max_key + 1));
+            case KeyDistribution::monotonic:
+                key = last_popped + 1 + (DistType)(r % 100);
+                return std::min(key, throughput_max_key);
+            case KeyDistribution::dijkstra:
+                key = last_popped + weights[r % weights.size()];
+                return std::min(key, throughput_max_key);
+            case KeyDistribution::ascending:
+                counter = counter > throughput_max_key - step ? counter % step : counter + step;
+                return counter;
+            case KeyDistribution::descending:
+                counter = counter > throughput_max_key - step ? counter % step : counter + step;
+                return throughput_max_key - counter;
+        }
+        return 0;
+    }
+};
+
+template<class Queue>
+void throughput_thread_routine(Queue & q, const Workload & workload, std::vector<typename Queue::Element> & own,
+                               boost::barrier & barrier, std::size_t num_threads, std::size_t thread_id,
+                               uint64_t & num_ops, double & seconds, uint64_t & empty_pops, uint64_t & stalls) {
+    using Element = typename Queue::Element;
+    const bool producer_consumer = workload.num_producers > 0;
+    const bool pushes = !producer_consumer || thread_id < workload.num_producers;
+    const bool pops = !producer_consumer || thread_id >= workload.num_producers;
+    const auto push_threshold = (uint64_t)(workload.push_fraction * (1 << 16));
+    const int subticks = 1000;
+
+    uint64_t seed = 2758756369U + thread_id;
+    KeyGenerator keys(workload.key_distribution, seed, (DistType)(workload.prefill + thread_id), (DistType)num_threads);
+    // Elements popped by this thread are owned by it and pushed again, unless popped by a pure consumer.
+    std::vector<Element *> free_elements;
+    free_elements.reserve(own.size());
+    std::size_t next_own = 0;
+    DistType last_popped = 0;
+
+    auto get_element_to_push = [&]() -> Element * {
+        if (!free_elements.empty()) {
+            Element * element = free_elements.back();
+            free_elements.pop_back();
+            return element;
+        }
+        if (producer_consumer) {
+            // A producer reuses its elements once consumers have popped them.
+            const std::size_t max_tries = 64;
+            for (std::size_t tries = 0; tries < max_tries; tries++) {
+                Element * element = &own[next_own++ % own.size()];
+                if (element->get_q_id_relaxed() == -1) {
+                    return element;
+                }
+            }
+            return nullptr;
+        }
+        return next_own < own.size() ? &own[next_own++] : nullptr;
+    };
+
+    barrier.wait();
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        for (int j = 0; j < subticks; j++) {
+            bool push = pushes && (!pops || (random_fnv1a(seed) >> 48) < push_threshold);
+            if (push) {
+                Element * element = get_element_to_push();
+                if (element == nullptr) {
+                    stalls++;
+                    continue;
+                }
+                element->set_dist_relaxed(std::numeric_limits<DistType>::max());
+                q.push(element, keys.next(last_popped));
+            } else {
+                Element * element = q.pop();
+                if (element == &Element::empty_element) {
+                    empty_pops++;
+                    continue;
+                }
+                if (!producer_consumer) {
+                    last_popped = element->get_dist_relaxed();
+                    free_elements.push_back(element);
+                }
+            }
+            num_ops++;
+        }
+        auto end = std::chrono::steady_clock::now();
+        if (end - start >= workload.duration) {
+            seconds = std::chrono::duration<double>(end - start).count();
+            break;
+        }
+    }
+    barrier.wait();
+}
+
+template<class Queue>
+ThroughputResult run_throughput(std::size_t num_threads, int size_multiple, const Workload & workload) {
+    using Element = typename Queue::Element;
+    const std::size_t num_queues = num_threads * size_multiple;
+    const std::size_t max_size = workload.prefill + num_threads * workload.elements_per_thread;
+    const std::size_t one_queue_reserve_size = max_size / num_queues * 3 / 2 + 1'000;
+
+    Queue q(num_threads, size_multiple, one_queue_reserve_size);
+    // Outlive the threads, as elements pushed by one thread may stay in the queue.
+    std::vector<Element> prefill_elements(workload.prefill);
+    std::vector<std::vector<Element>> own_elements(num_threads);
+    KeyGenerator uniform_keys(KeyDistribution::uniform, 1, 0, 1);
+    for (std::size_t i = 0; i < prefill_elements.size(); i++) {
+        DistType key = uniform_keys.next(0);
+        if (workload.key_distribution == KeyDistribution::ascending) {
+            key = (DistType)i;
+        } else if (workload.key_distribution == KeyDistribution::descending) {
+            key = throughput_max_key - (DistType)i;
+        }
+        prefill_elements[i].vertex = i;
+        q.push(&prefill_elements[i], key);
+    }
+    for (auto & own : own_elements) {
+        own.resize(workload.elements_per_thread);
+    }
+
+    ThroughputResult result;
+    result.ops_per_thread.resize(num_threads);
+    result.seconds_per_thread.resize(num_threads);
+    std::vector<uint64_t> empty_pops(num_threads);
+    std::vector<uint64_t> stalls(num_threads);
+    std::vector<std::thread> threads;
+    boost::barrier barrier(num_threads);
+    for (std::size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+        threads.emplace_back(throughput_thread_routine<Queue>, std::ref(q), std::cref(workload),
+                             std::ref(own_elements[thread_id]), std::ref(barrier), num_threads, thread_id,
+                             std::ref(result.ops_per_thread[thread_id]), std::ref(result.seconds_per_thread[thread_id]),
+                             std::ref(empty_pops[thread_id]), std::ref(stalls[thread_id]));
+        pin_thread(thread_id, threads.back());
+    }
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+    result.empty_pops = std::accumulate(empty_pops.begin(), empty_pops.end(), 0ULL);
+    result.stalls = std::accumulate(stalls.begin(), stalls.end(), 0ULL);
+    return result;
+}
+
+#endif //MULTIQUEUE_THROUGHPUT_H
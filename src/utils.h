@@ -1,7 +1,15 @@
 #ifndef MULTIQUEUE_UTILS_H
 #define MULTIQUEUE_UTILS_H
 
-void pin_thread(std::size_t thread_id, std::thread& thread) {
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+inline void pin_thread(std::size_t thread_id, std::thread& thread) {
     cpu_set_t cpu_set;
     CPU_ZERO(&cpu_set);
     CPU_SET(thread_id, &cpu_set);
@@ -9,4 +17,45 @@ void pin_thread(std::size_t thread_id, std::thread& thread) {
     (void)rc;
 }
 
+// Pins the calling thread to cpu and returns its previous affinity, to be restored with set_current_thread_affinity.
+inline cpu_set_t pin_current_thread(std::size_t cpu) {
+    cpu_set_t previous;
+    CPU_ZERO(&previous);
+    pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &previous);
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(cpu, &cpu_set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+    (void)rc;
+    return previous;
+}
+
+inline void set_current_thread_affinity(const cpu_set_t & cpu_set) {
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpu_set);
+    (void)rc;
+}
+
+// Calls f(thread_id, begin, end) for blocks of [0, n) taken by num_threads threads in turn.
+template<class F>
+void parallel_for(std::size_t n, std::size_t num_threads, F f, std::size_t block_size = 1 << 12) {
+    std::atomic<std::size_t> next_block{0};
+    auto routine = [n, block_size, &next_block, &f](std::size_t thread_id) {
+        while (true) {
+            std::size_t begin = next_block.fetch_add(block_size, std::memory_order_relaxed);
+            if (begin >= n) {
+                break;
+            }
+            f(thread_id, begin, std::min(n, begin + block_size));
+        }
+    };
+    std::vector<std::thread> threads;
+    for (std::size_t thread_id = 1; thread_id < num_threads; thread_id++) {
+        threads.emplace_back(routine, thread_id);
+    }
+    routine(0);
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+}
+
 #endif //MULTIQUEUE_UTILS_H
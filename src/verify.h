@@ -0,0 +1,153 @@
+#ifndef MULTIQUEUE_VERIFY_H
+#define MULTIQUEUE_VERIFY_H
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "dijkstra.h"
+#include "utils.h"
+
+// Checks that dists are the shortest distances from start_vertex without computing them again. For positive
+// weights, dists are correct iff
+// 1) dists[start_vertex] == 0,
+// 2) no edge can be relaxed: dists[to] <= dists[from] + weight for each edge from a reached vertex,
+// 3) each reached vertex except start_vertex has a tight incoming edge: dists[to] == dists[from] + weight.
+// Unreachable vertices have the infinite distance and are covered by 2), as they can't have edges from reached ones.
+
+class VerificationResult {
+public:
+    bool ok = true;
+    std::string error;
+};
+
+inline VerificationResult verify_dists(const AdjList & graph, const DistVector & dists, Vertex start_vertex,
+                                       std::size_t num_threads = std::thread::hardware_concurrency()) {
+    const DistType infinity = std::numeric_limits<DistType>::max();
+    const std::size_t num_vertexes = graph.size();
+    VerificationResult result;
+    std::mutex result_mutex;
+    std::atomic<bool> failed{false};
+    auto fail = [&result, &result_mutex, &failed](const std::string & error) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        if (result.ok) {
+            result.ok = false;
+            result.error = error;
+        }
+        failed.store(true, std::memory_order_relaxed);
+    };
+
+    if (dists.size() != num_vertexes) {
+        fail("Expected " + std::to_string(num_vertexes) + " dists, got " + std::to_string(dists.size()));
+        return result;
+    }
+    if (num_vertexes == 0) {
+        return result;
+    }
+    if (dists[start_vertex] != 0) {
+        fail("Start vertex " + std::to_string(start_vertex) + " has dist " + std::to_string(dists[start_vertex]));
+        return result;
+    }
+
+    std::unique_ptr<std::atomic<bool>[]> has_tight_edge(new std::atomic<bool>[num_vertexes]());
+    parallel_for(num_vertexes, num_threads,
+            [&graph, &dists, &has_tight_edge, &failed, &fail, infinity](std::size_t, std::size_t begin, std::size_t end) {
+        if (failed.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for (Vertex from = begin; from < end; from++) {
+            if (dists[from] == infinity) {
+                continue;
+            }
+            if (dists[from] < 0) {
+                fail("Vertex " + std::to_string(from) + " has negative dist " + std::to_string(dists[from]));
+                return;
+            }
+            for (const Edge & edge : graph[from]) {
+                Vertex to = edge.get_to();
+                if (edge.get_weight() <= 0) {
+                    fail("Edge " + std::to_string(from) + " -> " + std::to_string(to) + " has non-positive weight");
+                    return;
+                }
+                int64_t new_dist = (int64_t)dists[from] + edge.get_weight();
+                if (new_dist < dists[to]) {
+                    fail("Edge " + std::to_string(from) + " -> " + std::to_string(to) + " relaxes dist "
+                         + std::to_string(dists[to]) + " to " + std::to_string(new_dist));
+                    return;
+                }
+                if (new_dist == dists[to] && !has_tight_edge[to].load(std::memory_order_relaxed)) {
+                    has_tight_edge[to].store(true, std::memory_order_relaxed);
+                }
+            }
+        }
+    });
+    if (failed.load()) {
+        return result;
+    }
+
+    parallel_for(num_vertexes, num_threads,
+            [&dists, &has_tight_edge, &fail, start_vertex, infinity](std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            if (v != start_vertex && dists[v] != infinity && !has_tight_edge[v].load(std::memory_order_relaxed)) {
+                fail("Vertex " + std::to_string(v) + " with dist " + std::to_string(dists[v])
+                     + " has no tight incoming edge");
+                return;
+            }
+        }
+    });
+    return result;
+}
+
+// Checks that parents form a shortest path tree for the (already verified) dists: each reached vertex except
+// start_vertex has a parent with a tight edge to it, others have no_parent.
+inline VerificationResult verify_parents(const AdjList & graph, const DistVector & dists, const ParentVector & parents,
+                                         Vertex start_vertex,
+                                         std::size_t num_threads = std::thread::hardware_concurrency()) {
+    const DistType infinity = std::numeric_limits<DistType>::max();
+    VerificationResult result;
+    std::mutex result_mutex;
+    auto fail = [&result, &result_mutex](const std::string & error) {
+        std::lock_guard<std::mutex> lock(result_mutex);
+        if (result.ok) {
+            result.ok = false;
+            result.error = error;
+        }
+    };
+    if (parents.size() != graph.size() || dists.size() != graph.size()) {
+        fail("Expected " + std::to_string(graph.size()) + " parents, got " + std::to_string(parents.size()));
+        return result;
+    }
+    parallel_for(graph.size(), num_threads,
+            [&graph, &dists, &parents, &fail, start_vertex, infinity](std::size_t, std::size_t begin, std::size_t end) {
+        for (Vertex v = begin; v < end; v++) {
+            CompactVertex parent = parents[v];
+            if (v == start_vertex || dists[v] == infinity) {
+                if (parent != no_parent) {
+                    fail("Vertex " + std::to_string(v) + " should have no parent, has " + std::to_string(parent));
+                    return;
+                }
+                continue;
+            }
+            bool has_tight_edge = false;
+            if (parent < graph.size() && dists[parent] != infinity) {
+                for (const Edge & edge : graph[parent]) {
+                    if (edge.get_to() == v && (int64_t)dists[parent] + edge.get_weight() == dists[v]) {
+                        has_tight_edge = true;
+                        break;
+                    }
+                }
+            }
+            if (!has_tight_edge) {
+                fail("Parent " + std::to_string(parent) + " of vertex " + std::to_string(v)
+                     + " has no tight edge to it");
+                return;
+            }
+        }
+    });
+    return result;
+}
+
+#endif //MULTIQUEUE_VERIFY_H
@@ -0,0 +1,52 @@
+#include <cstdio>
+#include <iterator>
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "../src/answer_io.h"
+
+TEST(AnswerIO, Text) {
+    std::vector<DistType> dists = {0, 7, -1, 1234567890, std::numeric_limits<DistType>::max(), 10};
+    dists.resize(2'500'000, 42);
+    std::string filename = ::testing::TempDir() + "answer_io_text.out";
+    ASSERT_TRUE(write_answer_text(filename, dists, 3));
+
+    std::ostringstream expected;
+    for (DistType dist : dists) {
+        expected << dist << '\n';
+    }
+    expected << '\n';
+    std::ifstream input(filename, std::ios::binary);
+    std::stringstream actual;
+    actual << input.rdbuf();
+    ASSERT_EQ(expected.str(), actual.str());
+    std::remove(filename.c_str());
+}
+
+TEST(AnswerIO, Binary) {
+    std::vector<DistType> dists = {0, 3, std::numeric_limits<DistType>::max(), 5};
+    std::string filename = ::testing::TempDir() + "answer_io_binary.bin";
+    ASSERT_TRUE(write_answer_binary(filename, dists));
+    std::vector<DistType> read_dists;
+    ASSERT_TRUE(read_answer_binary(filename, read_dists));
+    ASSERT_EQ(dists, read_dists);
+
+    // A truncated file, and a header claiming more values than any memory could hold.
+    std::string contents;
+    {
+        std::ifstream input(filename, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    const std::size_t header_size = sizeof(binary_answer_magic) + 2 * sizeof(uint64_t);
+    std::ofstream(filename, std::ios::binary).write(contents.data(), (std::streamsize)contents.size() - 1);
+    ASSERT_FALSE(read_answer_binary(filename, read_dists));
+    std::string huge = contents;
+    const uint64_t num_dists = uint64_t(1) << 62;
+    huge.replace(header_size - sizeof(uint64_t), sizeof(uint64_t), reinterpret_cast<const char *>(&num_dists),
+                 sizeof(num_dists));
+    std::ofstream(filename, std::ios::binary).write(huge.data(), (std::streamsize)huge.size());
+    ASSERT_FALSE(read_answer_binary(filename, read_dists));
+
+    std::remove(filename.c_str());
+    ASSERT_FALSE(read_answer_binary(filename, read_dists));
+}
@@ -1,3 +1,5 @@
+#include <climits>
+
 #include "gtest/gtest.h"
 #include "../src/binary_heap.h"
 
@@ -25,4 +27,32 @@ TEST(BinaryHeap, Simple) {
         heap.pop();
     }
     ASSERT_TRUE(heap.empty());
-}
\ No newline at end of file
+}
+TEST(BinaryHeap, ElementLayouts) {
+    // The parent fits next to the spinlock, so tracking parents doesn't grow the elements.
+    ASSERT_EQ(32u, sizeof(BasicQueueElement<element_not_padded>));
+    ASSERT_EQ(32u + 64, sizeof(BasicQueueElement<element_padded<64>>));
+    ASSERT_EQ(128u, sizeof(BasicQueueElement<element_aligned<128>>));
+}
+TEST(BinaryHeap, DistTypes) {
+    ASSERT_EQ(7, DistTraits<int>::add(3, 4));
+    ASSERT_EQ(INT_MAX, DistTraits<int>::add(INT_MAX - 1, 2));
+    ASSERT_EQ(INT_MAX, DistTraits<int>::add(INT_MAX, INT_MAX));
+    ASSERT_EQ(UINT32_MAX, DistTraits<uint32_t>::add(3000000000U, 3000000000U));
+    ASSERT_EQ(6000000000ULL, DistTraits<uint64_t>::add(3000000000U, 3000000000U));
+    ASSERT_EQ(UINT64_MAX, DistTraits<uint64_t>::add(UINT64_MAX, 1));
+    ASSERT_EQ(DistTraits<float>::infinity(), DistTraits<float>::add(DistTraits<float>::infinity(), 1));
+
+    using Element = BasicQueueElement<element_not_padded, uint64_t>;
+    ASSERT_EQ(DistTraits<uint64_t>::infinity(), Element().get_dist());
+    std::vector<Element> vertexes(3);
+    my_d_ary_heap<4, Element> heap(10);
+    for (std::size_t i = 0; i < vertexes.size(); i++) {
+        vertexes[i].set_dist_relaxed(5000000000ULL + 10 - i);
+        heap.push(&vertexes[i]);
+    }
+    heap.decrease_key(&vertexes[0], 4000000000ULL);
+    ASSERT_EQ(&vertexes[0], heap.top());
+    heap.pop();
+    ASSERT_EQ(5000000008ULL, heap.top()->get_dist());
+}
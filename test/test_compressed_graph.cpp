@@ -0,0 +1,54 @@
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "../src/compressed_graph.h"
+#include "../src/generators.h"
+
+TEST(CompressedGraph, Simple) {
+    std::size_t num_vertexes = 5;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{4, 1}, {1, 300}, {1, 2}};
+    graph[3] = {{0, 100000}, {3, 7}, {2, 1 << 30}};
+    graph[4] = {{4, 5}};
+    CompressedGraph compressed(graph, 2);
+    ASSERT_EQ(num_vertexes, compressed.size());
+    ASSERT_EQ(7u, compressed.get_num_arcs());
+    ASSERT_TRUE(compressed[1].empty());
+
+    std::vector<std::pair<Vertex, DistType>> arcs;
+    for (Edge edge : compressed[3]) {
+        arcs.emplace_back(edge.get_to(), edge.get_weight());
+    }
+    ASSERT_EQ((std::vector<std::pair<Vertex, DistType>>({{0, 100000}, {2, 1 << 30}, {3, 7}})), arcs);
+    AdjList decompressed = compressed.decompress();
+    ASSERT_EQ(1u, decompressed[0][0].get_to());
+    ASSERT_EQ(4u, decompressed[0][2].get_to());
+    ASSERT_EQ(1, decompressed[0][2].get_weight());
+    ASSERT_EQ(5, decompressed[4][0].get_weight());
+
+    ASSERT_EQ(0u, CompressedGraph().size());
+    ASSERT_EQ(0u, CompressedGraph(AdjList()).size());
+}
+
+TEST(CompressedGraph, Dijkstra) {
+    std::size_t num_vertexes = 5000;
+    // Mostly close neighbours with small weights, as in road graphs, and some long arcs.
+    AdjList graph = generate_arcs(num_vertexes, 3 * num_vertexes, 7, 2,
+            [num_vertexes](std::mt19937_64 & random, Vertex & from, Vertex & to, DistType & weight) {
+        from = random() % num_vertexes;
+        bool long_arc = random() % 3 == 0;
+        to = long_arc ? random() % num_vertexes : (from + random() % 64) % num_vertexes;
+        weight = 1 + (DistType)(random() % (long_arc ? 100000 : 100));
+    });
+    CompressedGraph compressed(graph, 3);
+    ASSERT_LT(compressed.get_num_bytes(), compressed.get_num_arcs() * sizeof(Edge) / 2);
+
+    Timer timer;
+    DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+    ASSERT_EQ(expected, calc_dijkstra_sequential(compressed.decompress(), timer).get_dists());
+    for (std::size_t num_threads : {1, 4}) {
+        ASSERT_EQ(expected, calc_dijkstra(compressed, num_threads, 2, num_vertexes, timer).get_dists());
+        Multiqueue queue(num_threads, 2, num_vertexes);
+        ASSERT_EQ(expected, calc_dijkstra(compressed, queue, num_threads, timer, false, 8).get_dists());
+    }
+}
@@ -0,0 +1,129 @@
+#include <array>
+#include <cstdio>
+
+#include "gtest/gtest.h"
+#include "../src/contraction_hierarchies.h"
+#include "../src/generators.h"
+
+TEST(ContractionHierarchies, Simple) {
+    std::size_t num_vertexes = 6;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{1, 2}, {2, 5}, {0, 1}};
+    graph[1] = {{2, 1}, {3, 7}, {2, 3}};
+    graph[2] = {{3, 2}, {0, 1}};
+    graph[5] = {{4, 1}};
+
+    ContractionHierarchy ch = ContractionHierarchy::build(graph, 2);
+    Timer timer;
+    DistVector expected = {0, 2, 3, 5, INT_MAX, INT_MAX};
+    ASSERT_EQ(expected, ch.distances_from(0, 2, timer));
+    ASSERT_EQ(DistVector({INT_MAX, INT_MAX, INT_MAX, INT_MAX, 1, 0}), ch.distances_from(5, 1, timer));
+    ASSERT_EQ(DistVector({0, INT_MAX, 0, 1}), ch.distances({{3, 3}, {3, 0}, {2, 2}, {1, 2}}, 2));
+}
+
+TEST(ContractionHierarchies, Witnesses) {
+    // v = 0 between u = 1 and w = 2, with the witness u - x - w through x = 3, and leaves y = 4 and z = 5 which make v
+    // the only vertex of the first round next to x. A witness search which stops before settling w adds u <-> w.
+    AdjList graph(6, std::vector<Edge>());
+    for (auto edge : std::vector<std::array<DistType, 3>>({{1, 0, 5}, {0, 2, 6}, {1, 3, 1}, {3, 2, 1}, {2, 4, 1},
+                                                             {3, 5, 1}})) {
+        graph[edge[0]].emplace_back(edge[1], edge[2]);
+        graph[edge[1]].emplace_back(edge[0], edge[2]);
+    }
+    for (std::size_t num_threads : {1, 3}) {
+        ASSERT_EQ(12u, ContractionHierarchy::build(graph, num_threads).get_num_arcs()) << num_threads;
+    }
+}
+
+TEST(ContractionHierarchies, SearchSpaceGrows) {
+    AdjList graph = generate_graph("grid:30:30:5", 2);
+    Timer timer;
+    DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+    SearchSpace space(graph.size(), graph.size(), 1);
+    space.relax(0, 0);
+    while (!space.empty()) {
+        SearchSpace::Element * element = space.pop();
+        Vertex v = element->vertex;
+        DistType dist = element->get_dist_relaxed();
+        ASSERT_EQ(expected[v], dist);
+        for (const Edge & edge : graph[v]) {
+            space.relax(edge.get_to(), dist + edge.get_weight());
+        }
+    }
+    // A bounded search space doesn't grow past its bound.
+    SearchSpace bounded(graph.size(), 2, 1);
+    ASSERT_TRUE(bounded.relax(0, 0));
+    ASSERT_TRUE(bounded.relax(1, 1));
+    ASSERT_FALSE(bounded.relax(2, 1));
+}
+
+TEST(ContractionHierarchies, Dijkstra) {
+    for (const AdjList & graph : {generate_graph("er:2000:6000:1", 2), generate_graph("grid:40:40:2", 2)}) {
+        ContractionHierarchy ch = ContractionHierarchy::build(graph, 3);
+        ASSERT_TRUE(ch.matches(graph));
+        Timer timer;
+        for (Vertex start : {0, 7, 1234}) {
+            AdjList shifted = graph;
+            // calc_dijkstra_sequential starts from vertex 0.
+            std::swap(shifted[0], shifted[start]);
+            for (auto & edges : shifted) {
+                for (Edge & edge : edges) {
+                    Vertex to = edge.get_to();
+                    edge.set_to(to == 0 ? start : to == start ? 0 : to);
+                }
+            }
+            DistVector expected = calc_dijkstra_sequential(shifted, timer).get_dists();
+            std::swap(expected[0], expected[start]);
+            ASSERT_EQ(expected, ch.distances_from(start, 3, timer));
+
+            std::vector<std::pair<Vertex, Vertex>> pairs;
+            for (Vertex to = 0; to < graph.size(); to += 13) {
+                pairs.emplace_back(start, to);
+            }
+            DistVector dists = ch.distances(pairs, 2);
+            for (std::size_t i = 0; i < pairs.size(); i++) {
+                ASSERT_EQ(expected[pairs[i].second], dists[i]);
+            }
+        }
+    }
+}
+
+TEST(ContractionHierarchies, Core) {
+    AdjList graph = generate_graph("er:1000:4000:4", 2);
+    CHParams params;
+    params.core_degree = 5;
+    ContractionHierarchy ch = ContractionHierarchy::build(graph, 2, params);
+    ASSERT_GT(ch.get_core_size(), 0u);
+    ASSERT_LT(ch.get_core_size(), graph.size());
+    Timer timer;
+    DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+    ASSERT_EQ(expected, ch.distances_from(0, 2, timer));
+    std::vector<std::pair<Vertex, Vertex>> pairs;
+    for (Vertex to = 0; to < graph.size(); to++) {
+        pairs.emplace_back(0, to);
+    }
+    ASSERT_EQ(expected, ch.distances(pairs, 2));
+}
+
+TEST(ContractionHierarchies, SaveLoad) {
+    AdjList graph = generate_graph("grid:20:20:3", 2);
+    ContractionHierarchy ch = ContractionHierarchy::build(graph, 2);
+    std::string filename = testing::TempDir() + "ch_save_load.ch";
+    ASSERT_TRUE(ch.save(filename));
+
+    ContractionHierarchy loaded;
+    ASSERT_TRUE(loaded.load(filename));
+    ASSERT_TRUE(loaded.matches(graph));
+    ASSERT_FALSE(loaded.matches(generate_graph("grid:21:21:3", 2)));
+    // The same shape with another weight.
+    AdjList reweighted = graph;
+    reweighted[7][0].set_weight(reweighted[7][0].get_weight() + 1);
+    ASSERT_FALSE(loaded.matches(reweighted));
+    ASSERT_EQ(ch.get_num_levels(), loaded.get_num_levels());
+    ASSERT_EQ(ch.get_num_arcs(), loaded.get_num_arcs());
+    Timer timer;
+    ASSERT_EQ(ch.distances_from(5, 2, timer), loaded.distances_from(5, 2, timer));
+    std::remove(filename.c_str());
+
+    ASSERT_FALSE(loaded.load(filename));
+}
@@ -1,5 +1,7 @@
 #include "gtest/gtest.h"
 #include "../src/dijkstra.h"
+#include "../src/generators.h"
+#include "../src/layouts.h"
 
 TEST(Dijkstra, Minimized) {
 
@@ -33,4 +35,65 @@ TEST(Dijkstra, Simple) {
     for (std::size_t i = 0; i < num_vertexes; i++) {
         ASSERT_EQ(expected[i], dists[i]);
     }
-}
\ No newline at end of file
+}
+TEST(Dijkstra, Layouts) {
+    std::size_t num_vertexes = 4;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{1, 5}, {2, 1}};
+    graph[2] = {{1, 1}, {3, 7}};
+    graph[1] = {{3, 1}};
+
+    DistVector expected = {0, 2, 1, 3};
+    for (const std::string queue_layout : {"not_padded", "padded64", "aligned128"}) {
+        for (const std::string element_layout : {"not_padded", "padded128", "aligned64"}) {
+            bool known = with_multiqueue_layout(queue_layout, element_layout, [&graph, &expected](auto tag) {
+                using Queue = typename decltype(tag)::type;
+                Timer timer;
+                DistVector dists = calc_dijkstra<Queue>(graph, 2, 2, 1000, timer).get_dists();
+                ASSERT_EQ(expected, dists);
+            });
+            ASSERT_TRUE(known);
+        }
+    }
+    ASSERT_FALSE(with_multiqueue_layout("padded", "not_padded", [](auto tag) { (void)tag; }));
+}
+TEST(Dijkstra, DistTypes) {
+    // The distances overflow int after two arcs.
+    std::size_t num_vertexes = 5;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    int weight = 1 << 30;
+    graph[0] = {{1, weight}, {4, 3}};
+    graph[1] = {{2, weight}};
+    graph[2] = {{3, weight}};
+
+    Timer timer;
+    std::vector<uint64_t> expected = {0, 1ULL << 30, 1ULL << 31, 3ULL << 30, 3};
+    ASSERT_EQ(expected, calc_dijkstra_dists<DistMultiqueue<uint64_t>>(graph, 2, 2, 1000, timer));
+    // Sums saturate at infinity instead of wrapping around.
+    ASSERT_EQ(DistVector({0, 1 << 30, INT_MAX, INT_MAX, 3}), calc_dijkstra(graph, 2, 2, 1000, timer).get_dists());
+    ASSERT_EQ(DistVector({0, 1 << 30, INT_MAX, INT_MAX, 3}), calc_dijkstra_sequential(graph, timer).get_dists());
+    ASSERT_EQ(std::vector<uint32_t>({0, 1U << 30, 1U << 31, 3U << 30, 3}),
+              calc_dijkstra_dists<DistMultiqueue<uint32_t>>(graph, 1, 2, 1000, timer));
+    ASSERT_EQ(std::vector<float>({0, 1 << 30, 1U << 31, 3U << 30, 3}),
+              calc_dijkstra_dists<DistMultiqueue<float>>(graph, 2, 2, 1000, timer));
+
+    ParentVector parents;
+    calc_dijkstra_dists<DistMultiqueue<uint64_t>>(graph, 2, 2, 1000, timer, &parents);
+    ASSERT_EQ(ParentVector({no_parent, 0, 1, 2, 0}), parents);
+}
+TEST(Dijkstra, Grouped) {
+    std::size_t num_vertexes = 5000;
+    AdjList graph = generate_graph("er:5000:15000:17", 2);
+    graph[1].emplace_back(1, 1);
+    Timer timer;
+    DistsAndStatistics expected = calc_dijkstra_sequential(graph, timer);
+    for (std::size_t num_threads : {1, 3}) {
+        for (std::size_t group_size : {2, 8, 64}) {
+            Multiqueue queue(num_threads, 2, num_vertexes);
+            DistsAndStatistics result = calc_dijkstra(graph, queue, num_threads, timer, true, group_size);
+            ASSERT_EQ(expected.get_dists(), result.get_dists()) << num_threads << " " << group_size;
+            ASSERT_EQ(num_vertexes, result.get_parents().size());
+            ASSERT_GT(result.get_num_pops(), 0u);
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "../src/generators.h"
+
+static std::size_t count_arcs(const AdjList & graph) {
+    std::size_t num_arcs = 0;
+    for (const auto & edges : graph) {
+        num_arcs += edges.size();
+    }
+    return num_arcs;
+}
+
+static bool same_graphs(const AdjList & a, const AdjList & b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (Vertex v = 0; v < a.size(); v++) {
+        if (a[v].size() != b[v].size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < a[v].size(); i++) {
+            if (a[v][i].get_to() != b[v][i].get_to() || a[v][i].get_weight() != b[v][i].get_weight()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Every arc u -> v has v -> u with the same weight.
+static bool is_symmetric(const AdjList & graph) {
+    for (Vertex v = 0; v < graph.size(); v++) {
+        for (const Edge & edge : graph[v]) {
+            const std::vector<Edge> & back = graph[edge.get_to()];
+            bool found = std::any_of(back.begin(), back.end(), [v, &edge](const Edge & e) {
+                return e.get_to() == v && e.get_weight() == edge.get_weight();
+            });
+            if (!found) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TEST(Generators, Sizes) {
+    AdjList grid = generate_graph("grid:30:20");
+    ASSERT_EQ(600u, grid.size());
+    ASSERT_EQ(2u * (29 * 20 + 30 * 19), count_arcs(grid));
+    ASSERT_TRUE(is_symmetric(grid));
+
+    AdjList rmat = generate_graph("rmat:10:8:3");
+    ASSERT_EQ(1024u, rmat.size());
+    ASSERT_EQ(8u * 1024, count_arcs(rmat));
+    // Power-law: the vertex 0 gets many more arcs than the average.
+    ASSERT_GT(rmat[0].size(), 10u * 8);
+
+    AdjList er = generate_graph("er:1000:5000");
+    ASSERT_EQ(1000u, er.size());
+    ASSERT_EQ(5000u, count_arcs(er));
+
+    AdjList geometric = generate_graph("geometric:5000:8:2");
+    ASSERT_EQ(5000u, geometric.size());
+    ASSERT_TRUE(is_symmetric(geometric));
+    double degree = (double)count_arcs(geometric) / 5000;
+    ASSERT_GT(degree, 6.0);
+    ASSERT_LT(degree, 9.0);
+
+    for (const AdjList * graph : {&grid, &rmat, &er, &geometric}) {
+        for (const auto & edges : *graph) {
+            for (const Edge & edge : edges) {
+                ASSERT_LT(edge.get_to(), graph->size());
+                ASSERT_GE(edge.get_weight(), 1);
+                ASSERT_LE(edge.get_weight(), generator_max_weight);
+            }
+        }
+    }
+}
+
+TEST(Generators, Seeds) {
+    for (const std::string spec : {"grid:50:40:7", "rmat:12:4:7", "er:3000:10000:7", "geometric:3000:6:7"}) {
+        AdjList graph = generate_graph(spec, 1);
+        ASSERT_TRUE(same_graphs(graph, generate_graph(spec, 4))) << spec;
+        ASSERT_FALSE(same_graphs(graph, generate_graph(spec.substr(0, spec.size() - 1) + "8", 4))) << spec;
+    }
+}
+
+TEST(Generators, Specs) {
+    ASSERT_TRUE(is_generator_spec("grid:1:1"));
+    ASSERT_FALSE(is_generator_spec("grid"));
+    ASSERT_FALSE(is_generator_spec("NY"));
+    ASSERT_FALSE(is_generator_spec("ring:10:10"));
+    ASSERT_THROW(generate_graph("grid:10"), std::invalid_argument);
+    ASSERT_THROW(generate_graph("grid:10:x"), std::invalid_argument);
+    ASSERT_THROW(generate_graph("er:10:10:1:1"), std::invalid_argument);
+    ASSERT_THROW(generate_graph("er:0:10"), std::invalid_argument);
+    ASSERT_THROW(generate_graph("grid:0:10"), std::invalid_argument);
+    ASSERT_THROW(generate_graph("grid:10:0"), std::invalid_argument);
+    ASSERT_THROW(generate_graph("geometric:100:0"), std::invalid_argument);
+    // Called directly, degree 0 gives isolated points.
+    AdjList isolated = generate_geometric(100, 0, 1, 2);
+    ASSERT_EQ(100u, isolated.size());
+    for (const auto & edges : isolated) {
+        ASSERT_TRUE(edges.empty());
+    }
+    ASSERT_THROW(generate_graph("rmat:40:10"), std::invalid_argument);
+}
@@ -0,0 +1,62 @@
+#include <sstream>
+
+#include "gtest/gtest.h"
+#include "../src/harness.h"
+
+TEST(Harness, Statistics) {
+    ASSERT_EQ(3.0, median({5, 1, 3}));
+    ASSERT_EQ(2.5, median({4, 1, 3, 2}));
+    std::pair<double, double> interval = median_confidence_interval({10, 11, 12, 13, 14, 15, 100});
+    ASSERT_LE(10.0, interval.first);
+    ASSERT_LE(interval.first, 13.0);
+    ASSERT_LE(13.0, interval.second);
+    ASSERT_LT(interval.second, 100.0);
+
+    // Each of the 20 orderings of 3 + 3 values is equally likely, only one puts all current values last.
+    ASSERT_DOUBLE_EQ(1.0 / 20, mann_whitney_greater_p_value({1, 2, 3}, {4, 5, 6}));
+    ASSERT_DOUBLE_EQ(1.0, mann_whitney_greater_p_value({4, 5, 6}, {1, 2, 3}));
+    ASSERT_DOUBLE_EQ(2.0 / 20, mann_whitney_greater_p_value({1, 2, 4}, {3, 5, 6}));
+    std::vector<double> baseline, slower;
+    for (int i = 0; i < 60; i++) {
+        baseline.push_back(100 + i % 7);
+        slower.push_back(104 + i % 7);
+    }
+    ASSERT_LT(mann_whitney_greater_p_value(baseline, slower), 0.001);
+    ASSERT_GT(mann_whitney_greater_p_value(baseline, baseline), 0.4);
+}
+
+TEST(Harness, Json) {
+    HostTopology host;
+    host.cpu_model = "Some \"CPU\"";
+    host.hardware_threads = 8;
+    HarnessResult sequential;
+    sequential.graph = "grid:10:10";
+    sequential.engine = "Sequential";
+    sequential.times_ms = {10, 12, 11, 10, 10};
+    HarnessResult parallel = sequential;
+    parallel.engine = "4 4";
+    parallel.times_ms = {5, 5.5, 5.25, 5, 6};
+    parallel.speedup = 2;
+
+    std::stringstream json;
+    write_harness_json(json, host, "{}", {sequential, parallel});
+    HostTopology read_host;
+    std::vector<HarnessResult> read_results;
+    ASSERT_TRUE(read_harness_json(json, read_host, read_results));
+    ASSERT_EQ(host.cpu_model, read_host.cpu_model);
+    ASSERT_EQ(8u, read_host.hardware_threads);
+    ASSERT_EQ(2u, read_results.size());
+    ASSERT_EQ("4 4", read_results[1].engine);
+    ASSERT_EQ(parallel.times_ms, read_results[1].times_ms);
+    ASSERT_EQ(10.0, read_results[0].get_median_ms());
+
+    HarnessResult slower = parallel;
+    slower.times_ms = {7, 7.5, 7.25, 7, 8};
+    HarnessResult faster = sequential;
+    faster.times_ms = {9, 9, 9, 9, 9};
+    std::vector<HarnessComparison> comparisons = compare_with_baseline(read_results, {faster, slower}, 0.05, 0.05);
+    ASSERT_EQ(2u, comparisons.size());
+    ASSERT_FALSE(comparisons[0].regression);
+    ASSERT_TRUE(comparisons[1].regression);
+    ASSERT_FALSE(compare_with_baseline(read_results, {slower}, 0.05, 0.5)[0].regression);
+}
@@ -0,0 +1,71 @@
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "../src/dijkstra.h"
+#include "../src/generators.h"
+#include "../src/hybrid_dijkstra.h"
+
+TEST(HybridDijkstra, MoveFrontier) {
+    std::vector<DistType> dists = {5, 3, 4, 2, 8};
+    std::vector<QueueElement> vertexes(dists.size());
+    Multiqueue queue(2, 2, 8);
+    for (std::size_t i = 0; i < dists.size(); i++) {
+        vertexes[i].vertex = i;
+        queue.push_singlethreaded(&vertexes[i], dists[i], 7);
+        ASSERT_LE(0, vertexes[i].get_q_id_relaxed());
+    }
+    // push reports whether it added the element, which the hybrid threads count.
+    QueueElement added(dists.size());
+    ASSERT_TRUE(queue.push(&added, 6, 7));
+    ASSERT_FALSE(queue.push(&added, 1, 7));
+    ASSERT_FALSE(queue.push(&vertexes[0], 9));
+    std::vector<Vertex> popped;
+    queue.pop_all_singlethreaded([&popped](QueueElement * element) {
+        ASSERT_EQ(-1, element->get_q_id_relaxed());
+        ASSERT_EQ(7u, element->get_parent_relaxed());
+        popped.push_back(element->vertex);
+    });
+    std::sort(popped.begin(), popped.end());
+    ASSERT_EQ(std::vector<Vertex>({0, 1, 2, 3, 4, 5}), popped);
+    ASSERT_EQ(&empty_element, queue.pop());
+}
+
+TEST(HybridDijkstra, Dijkstra) {
+    std::size_t num_vertexes = 5000;
+    AdjList graph = generate_graph("er:5000:15000:17", 2);
+    Timer timer;
+    DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+    std::size_t num_reachable = std::count_if(expected.begin(), expected.end(), [](DistType dist) {
+        return dist != DistTraits<DistType>::infinity();
+    });
+    for (std::size_t num_threads : {1, 4}) {
+        // Always parallel after the start vertex, switching back and forth, and never parallel.
+        for (std::size_t threshold : {1, 40, 1 << 30}) {
+            std::size_t num_switches = 0;
+            DistsAndStatistics result = calc_dijkstra_hybrid(graph, num_threads, 2, num_vertexes, threshold, timer,
+                                                             true, &num_switches);
+            ASSERT_EQ(expected, result.get_dists()) << num_threads << " " << threshold;
+            ASSERT_GE(result.get_num_pops(), num_reachable);
+            for (Vertex v = 1; v < num_vertexes; v++) {
+                if (expected[v] != DistTraits<DistType>::infinity()) {
+                    Vertex parent = result.get_parents()[v];
+                    ASSERT_TRUE(std::any_of(graph[parent].begin(), graph[parent].end(), [&](const Edge & e) {
+                        return e.get_to() == v && expected[parent] + e.get_weight() == expected[v];
+                    })) << v;
+                }
+            }
+            if (threshold == 1 << 30) {
+                ASSERT_EQ(0u, num_switches);
+                ASSERT_EQ(num_reachable, result.get_num_pops());
+            } else {
+                ASSERT_LT(0u, num_switches);
+            }
+        }
+    }
+}
+
+TEST(HybridDijkstra, Empty) {
+    Timer timer;
+    AdjList graph;
+    ASSERT_TRUE(calc_dijkstra_hybrid(graph, 2, 2, 4, 8, timer).get_dists().empty());
+}
@@ -0,0 +1,66 @@
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "../src/generators.h"
+#include "../src/incremental_dijkstra.h"
+#include "../src/verify.h"
+
+TEST(IncrementalDijkstra, Simple) {
+    std::size_t num_vertexes = 5;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{1, 1}, {2, 5}};
+    graph[1] = {{2, 1}, {3, 10}};
+    graph[2] = {{3, 1}};
+    graph[3] = {{4, 1}};
+
+    IncrementalDijkstra<> dijkstra(graph, 2, 2, 100);
+    ASSERT_EQ(DistVector({0, 1, 2, 3, 4}), dijkstra.get_dists());
+
+    Timer timer;
+    UpdateStatistics statistics = dijkstra.update({{1, 2, 7}}, timer);
+    ASSERT_EQ(DistVector({0, 1, 5, 6, 7}), dijkstra.get_dists());
+    ASSERT_EQ(3u, statistics.num_invalidated);
+    ASSERT_EQ(ParentVector({no_parent, 0, 0, 2, 3}), dijkstra.get_parents());
+
+    dijkstra.update({{1, 3, 2}, {0, 1, 2}}, timer);
+    ASSERT_EQ(DistVector({0, 2, 5, 4, 5}), dijkstra.get_dists());
+    ASSERT_EQ(ParentVector({no_parent, 0, 0, 1, 3}), dijkstra.get_parents());
+
+    ASSERT_THROW(dijkstra.update({{3, 4, 1}, {4, 3, 1}}, timer), std::invalid_argument);
+    ASSERT_THROW(dijkstra.update({{3, 4, 0}}, timer), std::invalid_argument);
+    ASSERT_EQ(1, dijkstra.get_graph()[3][0].get_weight());
+}
+
+TEST(IncrementalDijkstra, RandomBatches) {
+    std::size_t num_vertexes = 3000;
+    AdjList graph = generate_graph("er:3000:9000:3", 2);
+    uint64_t seed = 3;
+    IncrementalDijkstra<> dijkstra(graph, 3, 2, num_vertexes);
+    Timer timer;
+    for (int batch = 0; batch < 20; batch++) {
+        std::vector<EdgeWeightChange> changes;
+        ParentVector parents = dijkstra.get_parents();
+        for (int i = 0; i < 50; i++) {
+            Vertex from = random_fnv1a(seed) % num_vertexes;
+            const std::vector<Edge> & edges = dijkstra.get_graph()[from];
+            if (edges.empty()) {
+                continue;
+            }
+            Vertex to = edges[random_fnv1a(seed) % edges.size()].get_to();
+            changes.emplace_back(from, to, 1 + random_fnv1a(seed) % (2 * generator_max_weight));
+        }
+        // Break tree arcs, so that whole subtrees are recomputed.
+        for (Vertex v = 1; v < num_vertexes; v += 97) {
+            if (parents[v] != no_parent) {
+                changes.emplace_back(parents[v], v, 10 * generator_max_weight);
+            }
+        }
+        dijkstra.update(changes, timer);
+
+        const AdjList & changed_graph = dijkstra.get_graph();
+        DistVector expected = calc_dijkstra_sequential(changed_graph, timer).get_dists();
+        ASSERT_EQ(expected, dijkstra.get_dists());
+        VerificationResult result = verify_parents(changed_graph, expected, dijkstra.get_parents(), 0, 2);
+        ASSERT_TRUE(result.ok) << result.error;
+    }
+}
@@ -0,0 +1,46 @@
+#include "gtest/gtest.h"
+#include "../src/generators.h"
+#include "../src/mst.h"
+
+TEST(MST, Simple) {
+    std::size_t num_vertexes = 6;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{1, 4}, {2, 1}, {0, 1}};
+    graph[1] = {{2, 2}, {3, 5}, {2, 7}};
+    graph[2] = {{3, 8}};
+    graph[4] = {{5, 3}};
+    AdjList undirected = make_undirected(graph);
+    ASSERT_EQ(3u, undirected[1].size());
+
+    Timer timer;
+    MSTResult expected;
+    expected.total_weight = 1 + 2 + 5 + 3;
+    expected.num_edges = 4;
+    ASSERT_EQ(expected, calc_mst_kruskal(undirected, timer));
+    ASSERT_EQ(expected, calc_mst_boruvka(undirected, 2, timer));
+    ASSERT_EQ(expected, calc_mst_prim(undirected, 2, timer));
+    ASSERT_EQ(expected, calc_mst_prim(undirected, 2, timer, 2));
+}
+
+TEST(MST, Random) {
+    for (DistType max_weight : {3, 1000}) {
+        std::size_t num_vertexes = 5000;
+        AdjList graph = generate_arcs(num_vertexes, 2 * num_vertexes, 5, 2,
+                [num_vertexes, max_weight](std::mt19937_64 & random, Vertex & from, Vertex & to, DistType & weight) {
+            from = random() % num_vertexes;
+            to = random() % num_vertexes;
+            weight = 1 + (DistType)(random() % max_weight);
+        });
+        AdjList undirected = make_undirected(graph);
+        Timer timer;
+        MSTResult expected = calc_mst_kruskal(undirected, timer);
+        for (std::size_t num_threads : {1, 3}) {
+            ASSERT_EQ(expected, calc_mst_boruvka(undirected, num_threads, timer));
+            for (std::size_t max_fragment_size : {4, 64, 1 << 16}) {
+                MSTResult result = calc_mst_prim(undirected, num_threads, timer, max_fragment_size);
+                ASSERT_EQ(expected.total_weight, result.total_weight) << max_weight << " " << max_fragment_size;
+                ASSERT_EQ(expected.num_edges, result.num_edges);
+            }
+        }
+    }
+}
@@ -1,4 +1,10 @@
+#include <atomic>
+#include <set>
+#include <thread>
+
 #include "gtest/gtest.h"
+#include "../src/dijkstra.h"
+#include "../src/generators.h"
 #include "../src/multiqueue.h"
 
 TEST(Multiqueue, Simple) {
@@ -18,4 +24,91 @@ TEST(Multiqueue, Simple) {
     }
     ASSERT_NE(element, &empty_element);
     ASSERT_EQ(dists[0], element->get_dist());
-}
\ No newline at end of file
+}
+TEST(Multiqueue, Layouts) {
+    using Element = BasicQueueElement<element_aligned<64>>;
+    using Queue = BasicMultiqueue<not_padded<my_d_ary_heap<8, Element>>>;
+    ASSERT_EQ(0u, alignof(Element) % 64);
+    std::vector<Element> vertexes(3);
+    Queue multiqueue(1, 1, 100);
+    for (std::size_t i = 0; i < vertexes.size(); i++) {
+        vertexes[i].vertex = i;
+        multiqueue.push(&vertexes[i], 10 - i);
+    }
+    for (std::size_t i = vertexes.size(); i-- > 0; ) {
+        Element * element = multiqueue.pop();
+        ASSERT_EQ(&vertexes[i], element);
+    }
+    ASSERT_EQ(&Element::empty_element, multiqueue.pop());
+}
+TEST(Multiqueue, AdaptiveResize) {
+    std::size_t num_elements = 100;
+    std::vector<QueueElement> vertexes(num_elements);
+    // The queues grow past the reserve size when fewer of them are active.
+    AdaptiveMultiqueue multiqueue(2, 4, 4);
+    ASSERT_EQ(8u, multiqueue.get_num_active_queues());
+    for (std::size_t i = 0; i < num_elements; i++) {
+        vertexes[i].vertex = i;
+        multiqueue.push(&vertexes[i], 1000 + (int)i);
+    }
+    multiqueue.set_num_active_queues(0);
+    ASSERT_EQ(2u, multiqueue.get_num_active_queues());
+    multiqueue.push(&vertexes[num_elements - 1], 1);
+    ASSERT_EQ(&vertexes[num_elements - 1], multiqueue.pop());
+
+    std::set<Vertex> popped;
+    for (std::size_t i = 1; i < num_elements; i++) {
+        QueueElement * element = multiqueue.pop();
+        ASSERT_NE(&empty_element, element);
+        popped.insert(element->vertex);
+    }
+    ASSERT_EQ(num_elements - 1, popped.size());
+    ASSERT_EQ(&empty_element, multiqueue.pop());
+    multiqueue.set_num_active_queues(100);
+    ASSERT_EQ(8u, multiqueue.get_num_active_queues());
+    ASSERT_EQ(2u, multiqueue.get_num_resizes());
+
+    Multiqueue fixed(2, 4, 100);
+    fixed.set_num_active_queues(2);
+    ASSERT_EQ(8u, fixed.get_num_active_queues());
+}
+TEST(Multiqueue, AdaptiveDijkstra) {
+    std::size_t num_vertexes = 5000;
+    AdjList graph = generate_graph("er:5000:20000:11", 2);
+    Timer timer;
+    DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+    ASSERT_EQ(expected, calc_dijkstra<AdaptiveMultiqueue>(graph, 4, 4, 16, timer).get_dists());
+
+    // Resized by another thread while the Dijkstra runs.
+    std::size_t num_threads = 3;
+    AdaptiveMultiqueue queue(num_threads, 8, 16);
+    std::vector<QueueElement> vertexes;
+    vertexes.reserve(num_vertexes);
+    for (std::size_t i = 0; i < num_vertexes; i++) {
+        vertexes.emplace_back(i);
+    }
+    queue.push_singlethreaded(&vertexes[0], 0);
+    std::atomic<bool> done{false};
+    std::thread resizer([&queue, &done]() {
+        for (std::size_t i = 0; !done.load(); i++) {
+            queue.set_num_active_queues(i % 2 == 0 ? 2 : 24);
+        }
+    });
+    std::vector<std::thread> threads;
+    boost::barrier barrier(num_threads);
+    for (std::size_t thread_id = 0; thread_id < num_threads; thread_id++) {
+        threads.emplace_back(dijkstra_thread_routine<AdaptiveMultiqueue>, std::cref(graph), std::ref(queue),
+                             std::ref(vertexes), std::ref(timer), std::ref(barrier), thread_id, nullptr);
+    }
+    for (std::thread & thread : threads) {
+        thread.join();
+    }
+    done.store(true);
+    resizer.join();
+    // Pops might have missed elements which the resizer was moving, but none may be lost in an inactive queue.
+    boost::barrier single_barrier(1);
+    dijkstra_thread_routine(graph, queue, vertexes, timer, single_barrier, 0);
+    for (std::size_t i = 0; i < num_vertexes; i++) {
+        ASSERT_EQ(expected[i], vertexes[i].get_dist());
+    }
+}
@@ -0,0 +1,52 @@
+#include <stdexcept>
+
+#include "gtest/gtest.h"
+#include "../src/sequential_dijkstra.h"
+#include "../src/generators.h"
+#include "../src/verify.h"
+
+TEST(SequentialDijkstra, Simple) {
+    std::size_t num_vertexes = 6;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{1, 4}, {2, 1}, {0, 3}};
+    graph[2] = {{1, 2}, {3, 0}};
+    graph[1] = {{3, 5}, {4, 1 << 30}};
+    CompactGraph compact(graph);
+    ASSERT_EQ(7u, compact.get_num_arcs());
+    ASSERT_EQ(1 << 30, compact.get_max_weight());
+
+    Timer timer;
+    DistVector expected = {0, 3, 1, 1, 3 + (1 << 30), INT_MAX};
+    ASSERT_EQ(expected, calc_dijkstra_dary(compact, timer).get_dists());
+    ASSERT_EQ(expected, calc_dijkstra_radix(compact, timer).get_dists());
+    ASSERT_THROW(calc_dijkstra_dial(compact, timer), std::invalid_argument);
+    graph[1].pop_back();
+    expected[4] = INT_MAX;
+    ASSERT_EQ(expected, calc_dijkstra_dial(CompactGraph(graph), timer).get_dists());
+
+    graph[5] = {{0, -1}};
+    ASSERT_THROW(CompactGraph{graph}, std::invalid_argument);
+    ASSERT_TRUE(calc_dijkstra_radix(CompactGraph(), timer).get_dists().empty());
+}
+
+TEST(SequentialDijkstra, Random) {
+    for (DistType max_weight : {1, 10, 100000}) {
+        // The Erdős–Rényi generator with zero weights and weights above generator_max_weight.
+        std::size_t num_vertexes = 5000;
+        AdjList graph = generate_arcs(num_vertexes, 3 * num_vertexes, 19, 2,
+                [num_vertexes, max_weight](std::mt19937_64 & random, Vertex & from, Vertex & to, DistType & weight) {
+            from = random() % num_vertexes;
+            to = random() % num_vertexes;
+            weight = (DistType)(random() % (max_weight + 1));
+        });
+        CompactGraph compact(graph);
+        Timer timer;
+        DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+        for (auto engine : {&calc_dijkstra_dary, &calc_dijkstra_radix, &calc_dijkstra_dial}) {
+            DistsAndStatistics result = engine(compact, timer, true);
+            ASSERT_EQ(expected, result.get_dists()) << max_weight;
+            ASSERT_TRUE(verify_parents(graph, result.get_dists(), result.get_parents(), 0, 2).ok);
+            ASSERT_TRUE(engine(compact, timer, false).get_parents().empty());
+        }
+    }
+}
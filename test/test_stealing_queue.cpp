@@ -0,0 +1,64 @@
+#include <algorithm>
+
+#include "gtest/gtest.h"
+#include "../src/dijkstra.h"
+#include "../src/generators.h"
+#include "../src/stealing_queue.h"
+
+TEST(StealingQueue, Simple) {
+    std::vector<DistType> dists = {5, 3, 4, 2, 8, 7};
+    std::vector<QueueElement> vertexes(dists.size());
+    StealingQueue queue(2, 2, 2);
+    for (std::size_t i = 0; i < dists.size(); i++) {
+        vertexes[i].vertex = i;
+        ASSERT_TRUE(queue.push(&vertexes[i], dists[i]));
+    }
+    // A decrease_key doesn't add the element.
+    ASSERT_FALSE(queue.push(&vertexes[4], 1));
+    ASSERT_FALSE(queue.push(&vertexes[4], 6));
+    // One thread pops the best of its own heaps, which grow past the reserve size.
+    std::vector<Vertex> popped;
+    for (std::size_t i = 0; i < dists.size(); i++) {
+        QueueElement * element = queue.pop();
+        ASSERT_NE(&empty_element, element);
+        popped.push_back(element->vertex);
+    }
+    ASSERT_EQ(std::vector<Vertex>({4, 3, 1, 2, 0, 5}), popped);
+    ASSERT_EQ(&empty_element, queue.pop());
+    ASSERT_EQ(0u, queue.get_num_steals());
+
+    // The seed goes to the heaps of the thread which came first, another thread steals it.
+    StealingQueue stolen(2, 1, 4);
+    ASSERT_EQ(&empty_element, stolen.pop());
+    stolen.push_singlethreaded(&vertexes[0], 0);
+    QueueElement * element = nullptr;
+    std::thread thief([&stolen, &element]() {
+        element = stolen.pop();
+    });
+    thief.join();
+    ASSERT_EQ(&vertexes[0], element);
+    ASSERT_EQ(1u, stolen.get_num_steals());
+}
+
+TEST(StealingQueue, Dijkstra) {
+    std::size_t num_vertexes = 5000;
+    AdjList graph = generate_graph("er:5000:15000:13", 2);
+    Timer timer;
+    DistVector expected = calc_dijkstra_sequential(graph, timer).get_dists();
+    std::size_t num_reachable = std::count_if(expected.begin(), expected.end(), [](DistType dist) {
+        return dist != DistTraits<DistType>::infinity();
+    });
+    for (std::size_t num_threads : {1, 4}) {
+        for (DistType lag_threshold : {DistTraits<DistType>::infinity(), 0, 100}) {
+            StealingQueue queue(num_threads, 2, 16);
+            queue.set_lag_threshold(lag_threshold);
+            DistsAndStatistics result = calc_dijkstra(graph, queue, num_threads, timer, true);
+            ASSERT_EQ(expected, result.get_dists()) << num_threads << " " << lag_threshold;
+            ASSERT_GE(result.get_num_pops(), num_reachable);
+            ASSERT_EQ(result.get_num_pops() - num_reachable, result.get_num_wasted_pops());
+        }
+    }
+    DistsAndStatistics multiqueue_result = calc_dijkstra(graph, 1, 1, num_vertexes, timer);
+    ASSERT_EQ(num_reachable, multiqueue_result.get_num_pops());
+    ASSERT_EQ(0u, multiqueue_result.get_num_wasted_pops());
+}
@@ -0,0 +1,67 @@
+#include "gtest/gtest.h"
+#include "../src/throughput.h"
+
+TEST(Throughput, KeyDistributions) {
+    KeyGenerator ascending(KeyDistribution::ascending, 1, 0, 2);
+    KeyGenerator descending(KeyDistribution::descending, 1, 0, 2);
+    KeyGenerator monotonic(KeyDistribution::monotonic, 1, 0, 1);
+    DistType last_ascending = ascending.next(0);
+    DistType last_descending = descending.next(0);
+    for (int i = 0; i < 1000; i++) {
+        DistType key = ascending.next(0);
+        ASSERT_LT(last_ascending, key);
+        last_ascending = key;
+        key = descending.next(0);
+        ASSERT_GT(last_descending, key);
+        last_descending = key;
+        key = monotonic.next(500);
+        ASSERT_GT(key, 500);
+        ASSERT_LE(key, 600);
+    }
+}
+
+TEST(Throughput, Workloads) {
+    for (Workload workload : default_workloads()) {
+        workload.prefill = std::min<std::size_t>(workload.prefill, 10'000);
+        workload.elements_per_thread = 1'000;
+        workload.duration = std::chrono::milliseconds(20);
+        ThroughputResult result = run_throughput<Multiqueue>(2, 2, workload);
+        ASSERT_EQ(2u, result.ops_per_thread.size());
+        ASSERT_GT(result.get_total_ops(), 0u) << workload.name;
+        ASSERT_GT(result.get_mops(), 0) << workload.name;
+        ASSERT_GE(result.get_seconds(), 0.02) << workload.name;
+    }
+}
+
+TEST(Throughput, ParseWorkload) {
+    Workload workload = parse_workload("uniform:0.75:1000");
+    ASSERT_EQ("uniform:0.75:1000", workload.name);
+    ASSERT_EQ(KeyDistribution::uniform, workload.key_distribution);
+    ASSERT_DOUBLE_EQ(0.75, workload.push_fraction);
+    ASSERT_EQ(1000u, workload.prefill);
+    ASSERT_EQ(std::chrono::milliseconds(1000), workload.duration);
+    ASSERT_EQ(0u, workload.num_producers);
+
+    workload = parse_workload("dijkstra:0.5:0:20:1");
+    ASSERT_EQ(KeyDistribution::dijkstra, workload.key_distribution);
+    ASSERT_EQ(0u, workload.prefill);
+    ASSERT_EQ(std::chrono::milliseconds(20), workload.duration);
+    ASSERT_EQ(1u, workload.num_producers);
+
+    for (const char * spec : {"uniform", "uniform:0.5", "zipf:0.5:10", "uniform:1.5:10", "uniform:x:10",
+                              "uniform:0.5:-1", "uniform:0.5:10:0", "uniform:0.5:10:20:1:2"}) {
+        ASSERT_THROW(parse_workload(spec), std::invalid_argument) << spec;
+    }
+}
+
+TEST(Throughput, AllConsumersStalled) {
+    // Both threads are consumers of an empty queue, so no thread makes an operation.
+    Workload workload("consumers", KeyDistribution::uniform, 0.5, 0, 0);
+    workload.push_fraction = 0;
+    workload.elements_per_thread = 1'000;
+    workload.duration = std::chrono::milliseconds(20);
+    ThroughputResult result = run_throughput<Multiqueue>(2, 2, workload);
+    ASSERT_EQ(0u, result.get_total_ops());
+    ASSERT_GT(result.empty_pops, 0u);
+    ASSERT_EQ(0, result.get_cv_ops_per_thread());
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "../src/generators.h"
+#include "../src/verify.h"
+
+TEST(Verify, Simple) {
+    std::size_t num_vertexes = 6;
+    AdjList graph(num_vertexes, std::vector<Edge>());
+    graph[0] = {{1, 2}, {2, 5}};
+    graph[1] = {{2, 1}, {3, 7}};
+    graph[2] = {{3, 2}, {0, 1}};
+    graph[5] = {{4, 1}};
+
+    DistVector correct = {0, 2, 3, 5, INT_MAX, INT_MAX};
+    ASSERT_TRUE(verify_dists(graph, correct, 0, 3).ok);
+
+    DistVector too_big = correct;
+    too_big[3] = 6;
+    ASSERT_FALSE(verify_dists(graph, too_big, 0, 3).ok);
+
+    DistVector too_small = correct;
+    too_small[3] = 4;
+    ASSERT_FALSE(verify_dists(graph, too_small, 0, 3).ok);
+
+    DistVector unreachable_reached = correct;
+    unreachable_reached[4] = 1;
+    ASSERT_FALSE(verify_dists(graph, unreachable_reached, 0, 3).ok);
+
+    DistVector wrong_start = correct;
+    wrong_start[0] = 1;
+    ASSERT_FALSE(verify_dists(graph, wrong_start, 0, 3).ok);
+
+    ASSERT_FALSE(verify_dists(graph, DistVector(2, 0), 0, 3).ok);
+}
+
+TEST(Verify, Dijkstra) {
+    std::size_t num_vertexes = 1000;
+    AdjList graph = generate_graph("er:1000:4000:1", 2);
+    Timer timer;
+    DistVector dists = calc_dijkstra(graph, 2, 2, num_vertexes, timer).get_dists();
+    ASSERT_TRUE(verify_dists(graph, dists, 0, 4).ok) << verify_dists(graph, dists, 0, 4).error;
+}
+
+TEST(Verify, Parents) {
+    std::size_t num_vertexes = 2000;
+    // Small weights, so that many vertices have several shortest paths.
+    AdjList graph = generate_arcs(num_vertexes, 3 * num_vertexes, 2, 2,
+            [num_vertexes](std::mt19937_64 & random, Vertex & from, Vertex & to, DistType & weight) {
+        from = random() % num_vertexes;
+        to = random() % num_vertexes;
+        weight = 1 + (DistType)(random() % 10);
+    });
+    Timer timer;
+    DistsAndStatistics parallel = calc_dijkstra(graph, 3, 2, num_vertexes, timer, true);
+    DistsAndStatistics sequential = calc_dijkstra_sequential(graph, timer, true);
+    for (const DistsAndStatistics & answer : {parallel, sequential}) {
+        ASSERT_TRUE(verify_dists(graph, answer.get_dists(), 0, 2).ok);
+        VerificationResult result = verify_parents(graph, answer.get_dists(), answer.get_parents(), 0, 2);
+        ASSERT_TRUE(result.ok) << result.error;
+    }
+    ASSERT_TRUE(calc_dijkstra(graph, 2, 2, num_vertexes, timer).get_parents().empty());
+
+    ParentVector wrong_parents = parallel.get_parents();
+    wrong_parents[0] = 1;
+    ASSERT_FALSE(verify_parents(graph, parallel.get_dists(), wrong_parents, 0, 2).ok);
+    wrong_parents = parallel.get_parents();
+    Vertex reached = graph[0].front().get_to();
+    wrong_parents[reached] = (CompactVertex)reached;
+    ASSERT_FALSE(verify_parents(graph, parallel.get_dists(), wrong_parents, 0, 2).ok);
+}